@@ -0,0 +1,161 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "adcJitter.h"
+
+// Deviation (in ticks) at the low edge of bin 0.
+#define ADC_JITTER_HALF_RANGE_TICKS (ADC_JITTER_BIN_TICKS * ADC_JITTER_BIN_COUNT / 2)
+#define ADC_JITTER_NS_PER_TICK (1e9 / ADC_JITTER_TIMER_CLOCK_HZ)
+
+static uint32_t histogram[ADC_JITTER_BIN_COUNT];
+static uint32_t count;
+static uint32_t outOfRangeCount;
+static int32_t minTicks;
+static int32_t maxTicks;
+static uint32_t previousCounterValue;
+static bool havePrevious; // False until the first value sets the reference
+
+// Clears the statistics.
+void adcJitter_init() {
+    memset(histogram, 0, sizeof(histogram));
+    count = 0;
+    outOfRangeCount = 0;
+    minTicks = INT32_MAX;
+    maxTicks = INT32_MIN;
+    havePrevious = false;
+}
+
+// Records the private timer counter value read at an ADC read.
+void adcJitter_latch(uint32_t timerCounterValue) {
+    // The counter counts down, so a later read in this period than in the
+    // previous one (a longer interval) gives a positive deviation.
+    int32_t deviation = (int32_t)(previousCounterValue - timerCounterValue);
+    previousCounterValue = timerCounterValue;
+    if (!havePrevious) {
+        havePrevious = true;
+        return;
+    }
+    count++;
+    if (deviation < minTicks) minTicks = deviation;
+    if (deviation > maxTicks) maxTicks = deviation;
+    // Shifted so the division never sees a negative value
+    int32_t shifted = deviation + ADC_JITTER_HALF_RANGE_TICKS;
+    if (shifted < 0) {
+        outOfRangeCount++;
+        histogram[0]++;
+    } else if (shifted >= 2 * ADC_JITTER_HALF_RANGE_TICKS) {
+        outOfRangeCount++;
+        histogram[ADC_JITTER_BIN_COUNT - 1]++;
+    } else {
+        histogram[shifted / ADC_JITTER_BIN_TICKS]++;
+    }
+}
+
+// Returns the number of recorded intervals.
+uint32_t adcJitter_getCount() {
+    return count;
+}
+
+// Returns the smallest deviation seen so far, in ns.
+double adcJitter_getMinNs() {
+    return count ? minTicks * ADC_JITTER_NS_PER_TICK : 0;
+}
+
+// Returns the largest deviation seen so far, in ns.
+double adcJitter_getMaxNs() {
+    return count ? maxTicks * ADC_JITTER_NS_PER_TICK : 0;
+}
+
+// Returns the deviation (in ns) that percent percent of the intervals do not
+// exceed: the upper edge of the bin where the running count reaches it.
+double adcJitter_getPercentileNs(double percent) {
+    uint32_t total = count; // The ISR keeps counting while we walk the bins
+    if (total == 0) return 0;
+    uint32_t target = (uint32_t)(percent / 100 * total + 0.5);
+    if (target == 0) target = 1;
+    uint32_t running = 0;
+    for (uint16_t i = 0; i < ADC_JITTER_BIN_COUNT - 1; i++) {
+        running += histogram[i];
+        if (running >= target)
+            return ((i + 1) * ADC_JITTER_BIN_TICKS - ADC_JITTER_HALF_RANGE_TICKS) *
+                   ADC_JITTER_NS_PER_TICK;
+    }
+    // The last bin is open-ended
+    return adcJitter_getMaxNs();
+}
+
+// Returns the number of intervals that were outside the histogram range.
+uint32_t adcJitter_getOutOfRangeCount() {
+    return outOfRangeCount;
+}
+
+// Prints count, min/max and a few percentiles to the console.
+void adcJitter_print() {
+    printf("ADC sample interval deviation over %lu intervals (ns): min %.0f, "
+           "p1 %.0f, p50 %.0f, p99 %.0f, p99.9 %.0f, max %.0f, out of range %lu\n",
+           (unsigned long)adcJitter_getCount(), adcJitter_getMinNs(),
+           adcJitter_getPercentileNs(1), adcJitter_getPercentileNs(50),
+           adcJitter_getPercentileNs(99), adcJitter_getPercentileNs(99.9),
+           adcJitter_getMaxNs(), (unsigned long)adcJitter_getOutOfRangeCount());
+}
+
+/******************************************************
+******************** Test Routines ********************
+******************************************************/
+
+#define ADC_JITTER_TEST_PAIR_COUNT 1000
+#define ADC_JITTER_TEST_START_VALUE 2000
+#define ADC_JITTER_TEST_SMALL_TICKS 40 // Every 10th pair
+#define ADC_JITTER_TEST_LARGE_TICKS 400 // Every 100th pair
+#define ADC_JITTER_TEST_PERCENTILE_COUNT 4
+
+// Feeds a known sequence of counter values and checks the percentiles.
+void adcJitter_runTest() {
+    printf("STARTING: adcJitter_runTest()\n");
+    adcJitter_init();
+    // Each pair is one late sample: +d then -d. That gives 0.5% at -400,
+    // 4.5% at -40, 90% at 0, 4.5% at +40 and 0.5% at +400 ticks.
+    uint32_t counterValue = ADC_JITTER_TEST_START_VALUE;
+    adcJitter_latch(counterValue);
+    for (uint32_t k = 0; k < ADC_JITTER_TEST_PAIR_COUNT; k++) {
+        int32_t d = (k % 100 == 0) ? ADC_JITTER_TEST_LARGE_TICKS
+                    : (k % 10 == 0) ? ADC_JITTER_TEST_SMALL_TICKS : 0;
+        adcJitter_latch(counterValue - d);
+        adcJitter_latch(counterValue);
+    }
+    adcJitter_print();
+
+    double percents[ADC_JITTER_TEST_PERCENTILE_COUNT] = {1, 50, 99, 99.9};
+    int32_t expectedTicks[ADC_JITTER_TEST_PERCENTILE_COUNT] = {
+        -ADC_JITTER_TEST_SMALL_TICKS, 0, ADC_JITTER_TEST_SMALL_TICKS,
+        ADC_JITTER_TEST_LARGE_TICKS};
+    bool passed = adcJitter_getCount() == 2 * ADC_JITTER_TEST_PAIR_COUNT &&
+                  adcJitter_getOutOfRangeCount() == 0 &&
+                  adcJitter_getMinNs() == -ADC_JITTER_TEST_LARGE_TICKS * ADC_JITTER_NS_PER_TICK &&
+                  adcJitter_getMaxNs() == ADC_JITTER_TEST_LARGE_TICKS * ADC_JITTER_NS_PER_TICK;
+    // A percentile is the upper edge of the bin holding the expected value
+    for (uint16_t i = 0; i < ADC_JITTER_TEST_PERCENTILE_COUNT; i++) {
+        double ticks = adcJitter_getPercentileNs(percents[i]) / ADC_JITTER_NS_PER_TICK;
+        if (ticks <= expectedTicks[i] - 0.5 ||
+            ticks > expectedTicks[i] + ADC_JITTER_BIN_TICKS + 0.5)
+            passed = false;
+    }
+    printf("%s\n", passed ? "adcJitter test passed." : "adcJitter test FAILED.");
+    printf("TERMINATING: adcJitter_runTest()\n");
+}
+
+#ifdef ADCJITTER_HOST_MAIN
+// Stand-alone host test, see adcJitter.h.
+int main() {
+    adcJitter_runTest();
+    return 0;
+}
+#endif
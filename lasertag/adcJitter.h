@@ -0,0 +1,72 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef ADCJITTER_H_
+#define ADCJITTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef ZYBO_BOARD
+#include "xparameters.h"
+#endif
+
+// Measures how uniform the ADC sampling is. isr_function() latches the ARM
+// private timer counter (interrupts_getPrivateTimerCounterValue()) right at
+// each ADC read. The timer reloads on every interrupt, so the difference
+// between two consecutive latched values is how much the interval between two
+// samples deviated from the nominal 10 us period. The deviations go into a
+// fixed histogram, so percentiles can be read at any time in constant memory.
+//   gcc -DADCJITTER_HOST_MAIN -I. adcJitter.c
+
+// Private timer clock (half the CPU clock, see interrupts.c). The host value
+// matches the ZYBO board.
+#ifdef ZYBO_BOARD
+#define ADC_JITTER_TIMER_CLOCK_HZ (XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)
+#else
+#define ADC_JITTER_TIMER_CLOCK_HZ 325000000
+#endif
+
+// Histogram bin width and count, in private timer ticks. Deviations outside
+// +-(ADC_JITTER_BIN_TICKS * ADC_JITTER_BIN_COUNT / 2) ticks (about +-3 us)
+// are counted in the outermost bins.
+#define ADC_JITTER_BIN_TICKS 4
+#define ADC_JITTER_BIN_COUNT 512
+
+// Clears the statistics. The next latched value only sets the reference.
+void adcJitter_init();
+
+// Records the private timer counter value read at an ADC read. Called from
+// isr_function() once per timer interrupt.
+void adcJitter_latch(uint32_t timerCounterValue);
+
+// Returns the number of recorded intervals.
+uint32_t adcJitter_getCount();
+
+// Returns the smallest and largest deviation from the nominal sample period
+// seen so far, in ns. A negative value means a short interval.
+double adcJitter_getMinNs();
+double adcJitter_getMaxNs();
+
+// Returns the deviation (in ns, at bin resolution) that percent percent of the
+// intervals do not exceed, e.g. 50 for the median or 99.9. Returns 0 if
+// nothing has been recorded.
+double adcJitter_getPercentileNs(double percent);
+
+// Returns the number of intervals that were outside the histogram range.
+uint32_t adcJitter_getOutOfRangeCount();
+
+// Prints count, min/max and a few percentiles to the console.
+void adcJitter_print();
+
+// Feeds a known sequence of counter values and checks the percentiles.
+// Runs without interrupts.
+void adcJitter_runTest();
+
+#endif /* ADCJITTER_H_ */
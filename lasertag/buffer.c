@@ -14,47 +14,79 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "buffer.h"
 
-#define BUFFER_SIZE 32768
- 
+#define BUFFER_SIZE 32768 // Must be a power of two.
+#define BUFFER_INDEX_MASK (BUFFER_SIZE - 1)
+
+#if (BUFFER_SIZE & BUFFER_INDEX_MASK) != 0
+#error "BUFFER_SIZE must be a power of two"
+#endif
+
+// L1 cache line size of the Cortex-A9. Blocks start on a cache line.
+#define BUFFER_CACHE_LINE_SIZE 32
+#define BUFFER_BLOCK_MASK (BUFFER_BLOCK_SIZE - 1)
+
+#if (BUFFER_SIZE % BUFFER_BLOCK_SIZE) != 0 || (BUFFER_BLOCK_SIZE & BUFFER_BLOCK_MASK) != 0
+#error "BUFFER_BLOCK_SIZE must be a power of two that divides BUFFER_SIZE"
+#endif
+
+// The buffer is a single-producer/single-consumer ring. The ISR (producer) is
+// the only writer of indexIn and the detector (consumer) is the only writer of
+// indexOut, so neither side needs to mask interrupts. Both indexes run freely
+// and are reduced to a slot with BUFFER_INDEX_MASK (BUFFER_SIZE is a power of
+// two, so the unsigned wrap-around of the indexes is harmless). The number of elements is
+// indexIn - indexOut.
+// When the buffer is full, the producer simply overwrites the oldest slot. The
+// consumer notices that indexIn - indexOut exceeds BUFFER_SIZE and skips the
+// overwritten elements, which keeps the "overwrite the oldest value" behavior
+// without the producer ever touching indexOut.
 typedef struct {
-    // Points to the next open slot.
+    // Number of values ever pushed. Written only by the producer.
     uint32_t indexIn;
-    // Points to the next element to be removed.
+    // Number of values ever removed. Written only by the consumer.
     uint32_t indexOut;
-    // Number of elements in the buffer.
-    uint32_t elementCount;
-    // Values are stored here.
-    buffer_data_t data[BUFFER_SIZE]; 
+    // 64-bit copy of indexOut: the sample index of the next value removed,
+    // counted from buffer_init(). Used only by the consumer.
+    uint64_t sampleIndexOut;
+    // Values are stored here, as BUFFER_SIZE / BUFFER_BLOCK_SIZE blocks.
+    buffer_data_t data[BUFFER_SIZE] __attribute__((aligned(BUFFER_CACHE_LINE_SIZE)));
 } buffer_t;
 
-volatile static buffer_t buffer;
+static buffer_t buffer;
 
-// This implements a dedicated circular buffer for storing values
-// from the ADC until they are read and processed by the detector.
-// The function of the buffer is similar to a buffer or FIFO.
+// Overflow telemetry, written only by the producer (except for resets).
+static buffer_stats_t stats;
+static uint32_t overflowEpisode; // Values dropped in the current episode.
 
 ///////////////////////
 /// HELPER FUNCTIONS //
 ///////////////////////
 
-// Return true if the buffer is empty
-static bool buffer_empty() {
-    return buffer.elementCount == 0;
+// Read indexIn. The acquire ordering makes the data it covers visible.
+static uint32_t buffer_loadIndexIn() {
+    return __atomic_load_n(&buffer.indexIn, __ATOMIC_ACQUIRE);
+}
+
+// Publish indexOut after the data it covers has been read.
+static void buffer_storeIndexOut(uint32_t indexOut) {
+    buffer.sampleIndexOut += (uint32_t)(indexOut - buffer.indexOut);
+    __atomic_store_n(&buffer.indexOut, indexOut, __ATOMIC_RELEASE);
 }
 
-// Return true if the buffer is full
-static bool buffer_full() {
-    return buffer.elementCount == BUFFER_SIZE;
+// Consumer side. Skip the elements the producer has overwritten since indexIn
+// was read. Returns the new indexOut.
+static uint32_t buffer_skipOverwritten(uint32_t indexIn, uint32_t indexOut) {
+    if (indexIn - indexOut > BUFFER_SIZE) return indexIn - BUFFER_SIZE;
+    return indexOut;
 }
 
-// Clear the buffer
+// Clear the buffer by dropping every unread value. Consumer side, O(1).
+// The stored values are left as they are, a slot is never read before it is
+// pushed again.
 void buffer_clear() {
-    // Reset all elements of the buffer to zero
-    for (uint32_t index = 0; index < BUFFER_SIZE; index++) {
-        buffer.data[index] = 0;
-    }
+    buffer_storeIndexOut(buffer_loadIndexIn());
 }
 
 /////////////////////
@@ -63,60 +95,160 @@ void buffer_clear() {
 
 // Initialize the buffer to empty.
 void buffer_init(void) {
-    // Reset buffer struct variables to zero or empty
-    buffer.indexIn = 0;
-    buffer.indexOut = 0;
-    buffer.elementCount = 0;
-
-    // Reset all elements to zero
-    buffer_clear();
+    // Reset buffer struct variables to empty
+    __atomic_store_n(&buffer.indexOut, 0, __ATOMIC_RELEASE);
+    buffer.sampleIndexOut = 0;
+    __atomic_store_n(&buffer.indexIn, 0, __ATOMIC_RELEASE);
+    buffer_resetStats();
 };
 
 // Remove a value from the buffer. Return zero if empty.
+// Consumer side, safe to call while the ISR is pushing.
 buffer_data_t buffer_pop(void) {
-    // Check for an empty buffer
-    if (buffer_empty()) {
-        // IF the buffer is empty, print an error
-        // message and DO NOT change the buffer.
-        printf("ERROR in buffer_pop(): Buffer is empty. Unable to pop.\n");
-        return 0;
+    uint32_t indexOut = buffer.indexOut;
+    while (true) {
+        uint32_t indexIn = buffer_loadIndexIn();
+        indexOut = buffer_skipOverwritten(indexIn, indexOut);
+        // Check for an empty buffer
+        if (indexIn == indexOut) {
+            // IF the buffer is empty, print an error
+            // message and DO NOT change the buffer.
+            printf("ERROR in buffer_pop(): Buffer is empty. Unable to pop.\n");
+            return 0;
+        }
+
+        buffer_data_t extractedData = buffer.data[indexOut & BUFFER_INDEX_MASK];
+
+        // Keep the value only if the producer did not overwrite it meanwhile
+        if (buffer_loadIndexIn() - indexOut <= BUFFER_SIZE) {
+            buffer_storeIndexOut(indexOut + 1);
+            return extractedData;
+        }
+    }
+};
+
+// Remove up to max values from the buffer into dst, oldest first.
+// Returns the number of values removed (0 if empty, no error is printed).
+// If firstIndex is not NULL, it receives the sample index of dst[0].
+// Consumer side, safe to call while the ISR is pushing. Copies at most two
+// contiguous spans.
+uint32_t buffer_popBlock(buffer_data_t *dst, uint32_t max, uint64_t *firstIndex) {
+    uint32_t indexOut = buffer.indexOut;
+    while (true) {
+        uint32_t indexIn = buffer_loadIndexIn();
+        indexOut = buffer_skipOverwritten(indexIn, indexOut);
+        uint32_t count = indexIn - indexOut;
+        if (count > max) count = max;
+        if (count == 0) {
+            buffer_storeIndexOut(indexOut);
+            return 0;
+        }
+
+        // Copy the span up to the end of the array, then the wrapped span
+        uint32_t slot = indexOut & BUFFER_INDEX_MASK;
+        uint32_t firstSpan = BUFFER_SIZE - slot;
+        if (firstSpan > count) firstSpan = count;
+        memcpy(dst, &buffer.data[slot], firstSpan * sizeof(buffer_data_t));
+        memcpy(dst + firstSpan, &buffer.data[0], (count - firstSpan) * sizeof(buffer_data_t));
+
+        // Drop the leading values the producer overwrote meanwhile
+        uint32_t overwritten = buffer_loadIndexIn() - indexOut;
+        overwritten = (overwritten > BUFFER_SIZE) ? overwritten - BUFFER_SIZE : 0;
+        if (overwritten >= count) {
+            indexOut += overwritten;
+            continue;
+        }
+        if (overwritten) {
+            memmove(dst, dst + overwritten, (count - overwritten) * sizeof(buffer_data_t));
+            count -= overwritten;
+        }
+        buffer_storeIndexOut(indexOut + overwritten + count);
+        if (firstIndex) *firstIndex = buffer.sampleIndexOut - count;
+        return count;
     }
+};
+
+// Get the oldest unread values in place, up to the end of their block, once
+// the ISR has filled that block. Returns the number of values at *block
+// (0 if the block is not complete yet). If firstIndex is not NULL, it
+// receives the sample index of (*block)[0]. Release the values with
+// buffer_releaseBlock() when done. Consumer side, no copy is made.
+uint32_t buffer_acquireBlock(const buffer_data_t **block, uint64_t *firstIndex) {
+    uint32_t indexIn = buffer_loadIndexIn();
+    uint32_t indexOut = buffer_skipOverwritten(indexIn, buffer.indexOut);
+    buffer_storeIndexOut(indexOut);
+    // Values from indexOut up to the next block boundary
+    uint32_t count = BUFFER_BLOCK_SIZE - (indexOut & BUFFER_BLOCK_MASK);
+    if (indexIn - indexOut < count) return 0;
+    *block = (const buffer_data_t *)&buffer.data[indexOut & BUFFER_INDEX_MASK];
+    if (firstIndex) *firstIndex = buffer.sampleIndexOut;
+    return count;
+};
 
-    // If the buffer is not empty, remove and return the oldest element in the
-    // buffer. Pop from buffer using MAGIC!
-    buffer_data_t extractedData = buffer.data[buffer.indexOut];
+// Release the count values returned by buffer_acquireBlock(). Returns false
+// if the ISR overwrote some of them while they were in use (only possible
+// after the buffer overflowed).
+bool buffer_releaseBlock(uint32_t count) {
+    uint32_t indexOut = buffer.indexOut;
+    bool intact = (buffer_loadIndexIn() - indexOut <= BUFFER_SIZE);
+    buffer_storeIndexOut(indexOut + count);
+    return intact;
+};
 
-    // Decrement element number and increment indexOut
-    buffer.elementCount--;
-    buffer.indexOut++;
-    buffer.indexOut = (buffer.indexOut) % BUFFER_SIZE;
+// Returns the sample index of the next value buffer_pop() returns, counted
+// from buffer_init(). Consumer side.
+uint64_t buffer_getReadIndex(void) {
+    return buffer.sampleIndexOut;
+};
 
-    // Return a buffer_data_t value
-    return extractedData;
+// Returns the number of values pushed since buffer_init(), i.e. the sample
+// index the ISR will give its next value. Consumer side.
+uint64_t buffer_getSampleCount(void) {
+    return buffer.sampleIndexOut + (uint32_t)(buffer_loadIndexIn() - buffer.indexOut);
 };
 
 // Add a value to the buffer. Overwrite the oldest value if full.
+// Producer side (ISR), never blocks and never touches indexOut.
 void buffer_pushover(buffer_data_t value) {
-    
-    // If the buffer is full, call buffer_pop before adding a value
-    if (buffer_full()) buffer_pop();
-    
-    // If the buffer is not full, push the new element to the buffer
-    // Push to buffer using MAGIC!
-    buffer.data[buffer.indexIn] = value;
-
-    // Increment element number and indexIn
-    buffer.elementCount++;
-    buffer.indexIn++;
-    buffer.indexIn = (buffer.indexIn) % BUFFER_SIZE;
+    uint32_t indexIn = buffer.indexIn;
+
+    // Telemetry: a full buffer means this push drops the oldest value
+    uint32_t waiting = indexIn - __atomic_load_n(&buffer.indexOut, __ATOMIC_RELAXED);
+    if (waiting >= BUFFER_SIZE) {
+        stats.droppedCount++;
+        stats.lastOverflowPush = indexIn;
+        if (++overflowEpisode > stats.longestOverflow) stats.longestOverflow = overflowEpisode;
+    } else {
+        overflowEpisode = 0;
+        if (waiting >= stats.highWaterMark) stats.highWaterMark = waiting + 1;
+    }
+
+    buffer.data[indexIn & BUFFER_INDEX_MASK] = value;
+    // Publish the value
+    __atomic_store_n(&buffer.indexIn, indexIn + 1, __ATOMIC_RELEASE);
 };
 
 // Return the number of elements in the buffer.
 uint32_t buffer_elements(void) {
-    return buffer.elementCount;
+    uint32_t count = buffer_loadIndexIn() - __atomic_load_n(&buffer.indexOut, __ATOMIC_ACQUIRE);
+    return (count > BUFFER_SIZE) ? BUFFER_SIZE : count;
 };
 
 // Return the capacity of the buffer in elements.
 uint32_t buffer_size(void) {
     return BUFFER_SIZE;
 };
+
+// Copy the overflow telemetry into dst. Can be called at any time.
+void buffer_getStats(buffer_stats_t *dst) {
+    *dst = stats;
+};
+
+// Reset the overflow telemetry.
+void buffer_resetStats(void) {
+    stats.highWaterMark = 0;
+    stats.droppedCount = 0;
+    stats.longestOverflow = 0;
+    stats.lastOverflowPush = 0;
+    overflowEpisode = 0;
+};
@@ -10,31 +10,79 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #ifndef BUFFER_H_
 #define BUFFER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 // This implements a dedicated circular buffer for storing values
 // from the ADC until they are read and processed by the detector.
 // The function of the buffer is similar to a queue or FIFO.
+// It is a single-producer/single-consumer ring: one context (the ISR) pushes
+// and one context (the detector) pops, and neither needs to disable
+// interrupts.
 
-// Type of elements in the buffer.
-typedef uint32_t buffer_data_t;
+// The ISR fills the buffer in blocks of this many values (1.28 ms of samples)
+// that the detector can process in place (see buffer_acquireBlock()).
+#define BUFFER_BLOCK_SIZE 128
+
+// Type of elements in the buffer. The ADC values are 12 bits wide.
+typedef uint16_t buffer_data_t;
+
+// Overflow telemetry, updated by buffer_pushover().
+typedef struct {
+  uint32_t highWaterMark;       // Most elements ever waiting in the buffer.
+  uint32_t droppedCount;        // Oldest values overwritten because it was full.
+  uint32_t longestOverflow;     // Most values dropped in a row (one episode).
+  uint32_t lastOverflowPush;    // Push count (ISR ticks) of the last drop.
+} buffer_stats_t;
 
 // Initialize the buffer to empty.
 void buffer_init(void);
 
-// Clear the buffer
+// Clear the buffer by dropping every unread value. Takes constant time.
 void buffer_clear();
 
+// Get the oldest unread values in place, up to the end of their block, once
+// the ISR has filled that block. Returns the number of values at *block
+// (0 if the block is not complete yet). If firstIndex is not NULL, it
+// receives the sample index of (*block)[0]. Release the values with
+// buffer_releaseBlock() when done. No copy is made.
+uint32_t buffer_acquireBlock(const buffer_data_t **block, uint64_t *firstIndex);
+
+// Release the count values returned by buffer_acquireBlock(). Returns false
+// if the ISR overwrote some of them while they were in use (only possible
+// after the buffer overflowed).
+bool buffer_releaseBlock(uint32_t count);
+
 // Add a value to the buffer. Overwrite the oldest value if full.
 void buffer_pushover(buffer_data_t value);
 
 // Remove a value from the buffer. Return zero if empty.
 buffer_data_t buffer_pop(void);
 
+// Remove up to max values from the buffer into dst, oldest first.
+// Returns the number of values removed (0 if empty). If firstIndex is not
+// NULL, it receives the sample index of dst[0].
+uint32_t buffer_popBlock(buffer_data_t *dst, uint32_t max, uint64_t *firstIndex);
+
+// Returns the sample index of the next value buffer_pop() returns.
+// Sample indexes count every value pushed since buffer_init() (one per ISR
+// tick) and never wrap in practice.
+uint64_t buffer_getReadIndex(void);
+
+// Returns the number of values pushed since buffer_init(), i.e. the sample
+// index the ISR will give its next value.
+uint64_t buffer_getSampleCount(void);
+
 // Return the number of elements in the buffer.
 uint32_t buffer_elements(void);
 
 // Return the capacity of the buffer in elements.
 uint32_t buffer_size(void);
 
+// Copy the overflow telemetry into dst. Can be called at any time.
+void buffer_getStats(buffer_stats_t *dst);
+
+// Reset the overflow telemetry.
+void buffer_resetStats(void);
+
 #endif /* BUFFER_H_ */
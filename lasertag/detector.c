@@ -15,9 +15,13 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdint.h>
 #include "interrupts.h"
 #include "buffer.h"
+#include "detector.h"
 #include "filter.h"
 #include "lockoutTimer.h"
 #include "hitLedTimer.h"
+#include "interCore.h"
+#include "intervalTimer.h"
+#include "transmitter.h"
 #include "utils.h"
 
 
@@ -29,12 +33,41 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define HALF_OF_MAX_ADC_VALUE 2047.5
 // 
 #define MEDIAN_POWER_VALUE_INDEX 4
-#define FUDGE_FACTOR 50
-#define FUDGE_FACTOR_DEFAULT_INDEX 4
+#define FUDGE_FACTOR_DEFAULT_INDEX 4 // Index of 50 in FUDGE_FACTORS
+#define FUDGE_FACTOR_COUNT FILTER_FREQUENCY_COUNT
+// Calibration picks a fudge factor at least this many times larger than the
+// strongest max/median power ratio seen with no shooters present.
+#define DETECTOR_CALIBRATION_SAFETY_MARGIN 2.0
+
+// Run the hit decision on every decimated output by default.
+#define DETECTOR_DEFAULT_DECISION_PERIOD 1
+// Report a hit on the first decision above the threshold by default.
+#define DETECTOR_DEFAULT_MIN_CONSECUTIVE_DECISIONS 1
+// Decision periods compared by detector_runDecisionRateTest().
+#define DETECTOR_DECISION_PERIODS {1, 4, 8, 16}
+#define DETECTOR_DECISION_PERIOD_COUNT 4
+// Decimated outputs timed by detector_runDecisionRateTest().
+#define DETECTOR_DECISION_TEST_OUTPUTS 10000
+// Time between decimated outputs (10 kHz), in milliseconds.
+#define DETECTOR_DECIMATED_OUTPUT_PERIOD_MS 0.1
+#define DETECTOR_DECISION_TEST_TIMER INTERVAL_TIMER_TIMER_1
+
+// After our own shot, hold the threshold until the power windows no longer
+// contain shot samples, in decimated outputs (one full power window).
+#define DETECTOR_SELF_TRANSMIT_GUARD_OUTPUTS FILTER_INPUT_PULSE_WIDTH
+
+// AMP mode: samples drained from the inter-core ring per block.
+#define DETECTOR_DRAIN_BLOCK_SIZE 64
+// AMP mode: core 1 lockout after a hit, in decimated outputs (0.5 s at 10 kHz).
+#define DETECTOR_CORE1_LOCKOUT_OUTPUTS 5000
+// AMP mode: core 1 sends a power snapshot this often, in decimated outputs.
+#define DETECTOR_CORE1_SNAPSHOT_OUTPUTS 1000
 
 #define QUEUE_1 {10, 20, 3000, 40, 50, 60, 70, 80, 2000, 15}
 #define QUEUE_2  {10, 20, 3000, 40, 500, 60, 70, 80, 10, 15}
 #define QUEUE_3 {10, 20, 30, 40, 20, 60, 70, 80, 100, 3000}
+#define QUEUE_4 {10, 20, 3000, 40, 50, 60, 70, 80, 2600, 15}
+#define DETECTOR_TEST_FLAT_POWER 50 // Same power in every band, no hit
 
 
 // 
@@ -42,13 +75,25 @@ typedef uint16_t detector_hitCount_t;
 
 
 // Global variables
+// In AMP mode (INTERCORE_AMP_MODE) core 1 runs the pipeline and is the only
+// writer of its state: powerValues, powerValues_sorted,
+// playerFrequencies_sorted, aboveThresholdStreaks, outputsSinceDecision,
+// selfTransmitFrequency, selfTransmitGuardOutputs, heldBaseLine, lastBaseLine
+// and the filter module. Core 0 owns the hit results and counts,
+// core1PowerValues and the flush bookkeeping, and resets core 1's state only
+// through a flush request. The configuration (ignoreAllHits,
+// ignoredPlayerFrequencies, fudge_factor, decisionPeriod,
+// minConsecutiveDecisions, selfTransmitMode) is
+// written by core 0 and only read by core 1; each is a single word, so core 1
+// picks up a change at a later decision.
 static uint64_t invocationCount;    // Number of times detector is called
 
 static bool ignoreAllHits;  // If true, ignore all hits
 static uint16_t frequencyNumberOfLastHit;   // Frequency of last hit
 
-static const uint32_t FUDGE_FACTORS[FILTER_FREQUENCY_COUNT];    // Possible fudge factors
+static const uint32_t FUDGE_FACTORS[FUDGE_FACTOR_COUNT] = {5, 10, 20, 30, 50, 75, 100, 150, 200, 500};    // Possible fudge factors
 static uint32_t fudge_factor_index; // Fudge factor array index
+static uint32_t savedFudgeFactorIndex = FUDGE_FACTOR_DEFAULT_INDEX; // Calibrated index, kept across detector_init()
 static uint32_t fudge_factor; // this is our fudge factor, but this is so we can modify the fudge factor later and iterate through.
 
 static bool ignoredPlayerFrequencies[FILTER_FREQUENCY_COUNT];   // Ignored player frequencies
@@ -59,21 +104,78 @@ static detector_hitCount_t detectorHitArray[FILTER_FREQUENCY_COUNT];    // Playe
 
 static bool detector_hitDetectedFlag;   // Hit detected
 
+static bool multiHitMode;   // If true, report every band above the threshold
+static detector_hitMask_t hitMaskOfLastHit;  // Frequencies of last hit
+static double hitMargins[FILTER_FREQUENCY_COUNT];  // Power above threshold of last hit
+static detector_hitScore_t hitScoreOfLastHit;  // Score of frequencyNumberOfLastHit
+static uint16_t aboveThresholdStreaks[FILTER_FREQUENCY_COUNT];  // Decisions in a row above the threshold
+static uint64_t currentSampleIndex;  // Sample index of the newest filtered sample
+static uint64_t sampleIndexOfLastHit;  // Sample index the last hit was decided on
+static double core1PowerValues[FILTER_FREQUENCY_COUNT];  // Newest snapshot from core 1 (AMP mode)
+
+static uint16_t decisionPeriod;  // Decimated outputs per hit decision
+static uint16_t minConsecutiveDecisions;  // Decisions above the threshold before a hit
+static uint16_t outputsSinceDecision;  // Decimated outputs since the last decision
+
+static detector_selfTransmitMode_t selfTransmitMode;  // Handling of our own shots
+static uint16_t selfTransmitFrequency;  // Frequency of our own shot
+static uint32_t selfTransmitGuardOutputs;  // Decimated outputs left with a held threshold
+static double heldBaseLine;  // Last threshold computed outside of our own shots
+static double lastBaseLine;  // Threshold of the last full decision
+
+static bool core1Started;  // AMP mode: detector_core1Main() is running on core 1
+static uint32_t flushSequence;  // AMP mode: flushes requested from core 1 so far
+
+
+// Reset the state of the filter pipeline: the power values, the streaks and
+// the threshold bookkeeping. In AMP mode only core 1 calls this once it runs.
+static void detector_resetPipeline() {
+   outputsSinceDecision = 0;
+   selfTransmitGuardOutputs = 0;
+   heldBaseLine = 0.0;
+   lastBaseLine = 0.0;
+   for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+       powerValues[i] = 0.0;
+       powerValues_sorted[i] = 0.0;
+       playerFrequencies_sorted[i] = 0;
+       aboveThresholdStreaks[i] = 0;
+   }
+}
+
+// Ask core 1 to drop its pending samples and reset its pipeline (AMP mode).
+// Core 1 may still be working through older samples when this returns, so
+// detector_pollCore1() drops every event that does not carry the new sequence.
+static void detector_flushCore1() {
+    interCore_event_t request;
+    request.type = interCore_flushEvent_e;
+    request.sequence = ++flushSequence;
+    // Core 1 takes one request per sample block, so the ring empties quickly
+    while (!interCore_pushRequest(&request));
+}
 
 // Initialize the detector module.
 // By default, all frequencies are considered for hits.
 // Assumes the filter module is initialized previously.
+// Once core 1 runs (AMP mode), its pipeline state is reset by a flush request
+// instead of being written from core 0.
 void detector_init(void) {
    // Reset booleans
    ignoreAllHits = false;
    detector_hitDetectedFlag = false;
+   multiHitMode = false;
+   decisionPeriod = DETECTOR_DEFAULT_DECISION_PERIOD;
+   minConsecutiveDecisions = DETECTOR_DEFAULT_MIN_CONSECUTIVE_DECISIONS;
+   selfTransmitMode = detector_selfTransmitProcess_e;
 
 
    // Reset numbers
-   fudge_factor_index = FUDGE_FACTOR_DEFAULT_INDEX;
+   fudge_factor_index = savedFudgeFactorIndex;
    invocationCount = 0;
    frequencyNumberOfLastHit = 0;
-   fudge_factor = FUDGE_FACTOR;
+   hitMaskOfLastHit = 0;
+   currentSampleIndex = 0;
+   sampleIndexOfLastHit = 0;
+   fudge_factor = FUDGE_FACTORS[fudge_factor_index];
 
 
    // Set all frequencies to not be ignored
@@ -81,16 +183,27 @@ void detector_init(void) {
    // have the same size
    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
        ignoredPlayerFrequencies[i] = true;
-       powerValues[i] = 0.0;
-       powerValues_sorted[i] = 0.0;
-       playerFrequencies_sorted[i] = 0;
        detectorHitArray[i] = 0;
+       hitMargins[i] = 0.0;
+       core1PowerValues[i] = 0.0;
    }
 
+   if (INTERCORE_AMP_MODE && core1Started) detector_flushCore1();
+   else detector_resetPipeline();
 };
 
 // Flush the array buffer values to avoid counting hits while in invincibility mode
+// In AMP mode core 1 owns the arrays and the sample ring, so core 0 only asks
+// it to flush; events decided before core 1 flushed are dropped when they
+// arrive (see detector_pollCore1()).
 void detector_flushDetector() {
+    if (INTERCORE_AMP_MODE) {
+        if (core1Started) detector_flushCore1();
+        for (uint32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+            core1PowerValues[i] = 0.0;
+        }
+        return;
+    }
     // Iterate over the arrays and set values to 0
     for (uint32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
         powerValues[i] = 0.0;
@@ -150,11 +263,9 @@ void detector_clearHit(void) {
 };
 
 
-// Detect a hit
-bool detector_hitCurrentlyDetected() {
-    // Optional debug statement
-    if (DEBUG_DETECTOR) printf("STARTING: detector_hitCurrentlyDetected\n");
-
+// Get the current power values, sort them and return the hit threshold
+// (median power value times the fudge factor)
+static double detector_computeBaseLine() {
     // Get current power values
     filter_getCurrentPowerValues(powerValues);
     
@@ -171,40 +282,201 @@ bool detector_hitCurrentlyDetected() {
     double powerValue_median = powerValues_sorted[MEDIAN_POWER_VALUE_INDEX];
     double base_line = powerValue_median * fudge_factor;
 
-    // Reset hitDetected;
-    detector_clearHit();
+    // Our own shot pollutes the median, keep the threshold from before it
+    if (selfTransmitGuardOutputs && heldBaseLine > 0.0) base_line = heldBaseLine;
+    else heldBaseLine = base_line;
+    lastBaseLine = base_line;
+    return base_line;
+}
+
+// True if hits on frequencyNumber must not be reported right now.
+static bool detector_frequencyIgnored(uint16_t frequencyNumber) {
+    return ignoreAllHits || ignoredPlayerFrequencies[frequencyNumber] ||
+           (selfTransmitGuardOutputs && frequencyNumber == selfTransmitFrequency);
+}
+
+// Checks our own transmitter once per batch of samples. Returns true if the
+// samples should be dropped (skip mode during a shot). While a shot is on the
+// air, and for DETECTOR_SELF_TRANSMIT_GUARD_OUTPUTS afterwards, the threshold
+// is held and our own frequency is ignored.
+static bool detector_checkSelfTransmit() {
+    if (selfTransmitMode == detector_selfTransmitProcess_e || !transmitter_running())
+        return false;
+    selfTransmitFrequency = transmitter_getFrequencyNumber();
+    selfTransmitGuardOutputs = DETECTOR_SELF_TRANSMIT_GUARD_OUTPUTS;
+    return selfTransmitMode == detector_selfTransmitSkip_e;
+}
+
+// Print the hit array for debugging
+static void detector_printHitArray() {
+    printf("detectorHitArray {");
+    // Print out hit counts for debug
+    for (int32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        printf("%d", detectorHitArray[i]);
+        printf((i < FILTER_FREQUENCY_COUNT - 1 ? "," : ""));
+    }
+    printf("}\n");
+}
+
+// True if frequencyNumber has been above the threshold for enough decisions in
+// a row to be reported. Call after detector_updateStreaks().
+static bool detector_streakLongEnough(uint16_t frequencyNumber) {
+    return aboveThresholdStreaks[frequencyNumber] >= minConsecutiveDecisions;
+}
+
+// Search the sorted power values, strongest first, for a band above base_line
+// that is not ignored and has a long enough streak. Does not register the hit.
+// Returns the index into the sorted arrays, or -1 if there is no hit.
+static int32_t detector_findStrongestHit(double base_line) {
     // Iterate through the sorted power values array...
     for (int32_t i = FILTER_FREQUENCY_COUNT - 1; i >= 0; i--) {
         // If the associated frequency is not ignored...
-        if (!ignoredPlayerFrequencies[playerFrequencies_sorted[i]] && !ignoreAllHits) {
+        if (!detector_frequencyIgnored(playerFrequencies_sorted[i]) &&
+            detector_streakLongEnough(playerFrequencies_sorted[i])) {
             // If the power value is greater than the base_line...
-            if (powerValues_sorted[i] > base_line) {
-                // Register the hit where needed
-                detector_hitDetectedFlag = true;
-                frequencyNumberOfLastHit = playerFrequencies_sorted[i];
-                detectorHitArray[frequencyNumberOfLastHit] += 1;
-
-                // Optional debug statement
-                if (DEBUG_DETECTOR || DEBUG_DETECTOR_HIT_ARRAY) {
-                    printf("detectorHitArray {");
-                    // Print out power values for debug
-                    for (int32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
-                        printf("%d", detectorHitArray[i]);
-                        printf((i < FILTER_FREQUENCY_COUNT - 1 ? "," : ""));
-                    }
-                    printf("}\n");
-                }
+            if (powerValues_sorted[i] > base_line) return i;
+        }
+    }
+    return -1;
+}
 
-                return detector_hitDetectedFlag;
-            }
+// Count the decisions in a row each band has been above base_line. Call once
+// per decision, after detector_computeBaseLine().
+static void detector_updateStreaks(double base_line) {
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        if (powerValues[i] > base_line) {
+            if (aboveThresholdStreaks[i] < UINT16_MAX) aboveThresholdStreaks[i]++;
+        } else {
+            aboveThresholdStreaks[i] = 0;
         }
     }
+}
+
+// Keep the streaks current while locked out, without the sort of
+// detector_computeBaseLine(): compares the current power values against the
+// threshold of the last full decision.
+static void detector_updateStreaksLockedOut() {
+    filter_getCurrentPowerValues(powerValues);
+    detector_updateStreaks(lastBaseLine);
+}
+
+// Score the hit on frequencyNumber against the median implied by base_line.
+// consecutiveDecisions is the streak of the band when the hit was decided.
+static void detector_scoreHit(uint16_t frequencyNumber, const double bandPowers[], double base_line,
+                              uint16_t consecutiveDecisions) {
+    double median = base_line / fudge_factor;
+    hitScoreOfLastHit.powerToMedianRatio = (median > 0.0) ? bandPowers[frequencyNumber] / median : 0.0;
+    hitScoreOfLastHit.margin = bandPowers[frequencyNumber] - base_line;
+    hitScoreOfLastHit.consecutiveDecisions = consecutiveDecisions;
+}
+
+// Register a hit on frequencyNumber. bandPowers, base_line and
+// consecutiveDecisions are the power values, threshold and streak the hit was
+// decided on.
+static void detector_registerHit(uint16_t frequencyNumber, const double bandPowers[], double base_line,
+                                 uint16_t consecutiveDecisions) {
+    detector_hitDetectedFlag = true;
+    frequencyNumberOfLastHit = frequencyNumber;
+    detectorHitArray[frequencyNumberOfLastHit] += 1;
+    hitMaskOfLastHit = (detector_hitMask_t)(1 << frequencyNumberOfLastHit);
+    sampleIndexOfLastHit = currentSampleIndex;
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+        hitMargins[band] = bandPowers[band] - base_line;
+    }
+    detector_scoreHit(frequencyNumber, bandPowers, base_line, consecutiveDecisions);
+
+    // Optional debug statement
+    if (DEBUG_DETECTOR || DEBUG_DETECTOR_HIT_ARRAY) detector_printHitArray();
+}
+
+// Detect a hit
+bool detector_hitCurrentlyDetected() {
+    // Optional debug statement
+    if (DEBUG_DETECTOR) printf("STARTING: detector_hitCurrentlyDetected\n");
+
+    double base_line = detector_computeBaseLine();
+    detector_updateStreaks(base_line);
+
+    // Reset hitDetected;
+    detector_clearHit();
+    // Register the strongest eligible band, if any
+    int32_t hitIndex = detector_findStrongestHit(base_line);
+    if (hitIndex >= 0) {
+        uint16_t frequencyNumber = playerFrequencies_sorted[hitIndex];
+        detector_registerHit(frequencyNumber, powerValues, base_line,
+                             aboveThresholdStreaks[frequencyNumber]);
+        return detector_hitDetectedFlag;
+    }
 
     // Optional debug statement
     if (DEBUG_DETECTOR) printf("TERMINATING: detector_hitCurrentlyDetected()\n");
     return detector_hitDetectedFlag;
 }
 
+// Multi-hit detection. Evaluates every band in one pass instead of stopping at
+// the strongest one. Ignored frequencies and frequencies that are still locked
+// out (see lockoutTimer_frequencyRunning()) are never reported. Each reported
+// band is counted in the hit array. margins[] is indexed by frequency number and
+// receives the power above the threshold for every band (negative if below).
+// Returns a bitmask of the bands that were hit, 0 if none.
+detector_hitMask_t detector_hitsCurrentlyDetected(double margins[]) {
+    double base_line = detector_computeBaseLine();
+    detector_updateStreaks(base_line);
+    detector_hitMask_t hitMask = 0;
+    double strongestMargin = 0.0;
+
+    // The flag is only set here, the consumer clears it with
+    // detector_clearHit(). There is no global lockout, so the next decision
+    // follows 0.1 ms later and would otherwise clear a hit before it is read.
+    // Iterate through every band (unsorted, indexed by frequency number)
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        margins[i] = powerValues[i] - base_line;
+        // Skip ignored and locked-out frequencies and bands below the base_line
+        // or not above it for long enough
+        if (detector_frequencyIgnored(i) || lockoutTimer_frequencyRunning(i) ||
+            margins[i] <= 0.0 || !detector_streakLongEnough(i)) {
+            continue;
+        }
+        // Register the hit for this band
+        hitMask |= (detector_hitMask_t)(1 << i);
+        detectorHitArray[i] += 1;
+        // The strongest band is reported as the frequency of the last hit
+        if (margins[i] > strongestMargin) {
+            strongestMargin = margins[i];
+            frequencyNumberOfLastHit = i;
+        }
+    }
+
+    // Remember the hit so it can be queried later
+    if (hitMask) {
+        detector_hitDetectedFlag = true;
+        hitMaskOfLastHit = hitMask;
+        sampleIndexOfLastHit = currentSampleIndex;
+        for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+            hitMargins[i] = margins[i];
+        }
+        detector_scoreHit(frequencyNumberOfLastHit, powerValues, base_line,
+                          aboveThresholdStreaks[frequencyNumberOfLastHit]);
+        // Optional debug statement
+        if (DEBUG_DETECTOR || DEBUG_DETECTOR_HIT_ARRAY) detector_printHitArray();
+    }
+    return hitMask;
+}
+
+// Enable or disable multi-hit mode. When enabled, detector() uses
+// detector_hitsCurrentlyDetected() and a separate lockout per frequency
+// instead of the single global lockoutTimer, so concurrent shooters are all
+// credited. Disabled by default. Core 1 only makes single-hit decisions, so in
+// AMP mode enabling it is refused. Returns false if refused.
+bool detector_setMultiHitMode(bool enable) {
+    if (enable && INTERCORE_AMP_MODE) {
+        printf("ERROR in detector_setMultiHitMode(): not supported in AMP mode.\n");
+        return false;
+    }
+    multiHitMode = enable;
+    return true;
+}
+
 // Returns true if a hit was detected.
 bool detector_hitPreviouslyDetected(void) {
    return detector_hitDetectedFlag;
@@ -216,6 +488,32 @@ uint16_t detector_getFrequencyNumberOfLastHit(void) {
    return frequencyNumberOfLastHit;
 };
 
+// Returns the score of the band reported by
+// detector_getFrequencyNumberOfLastHit(), as taken when the hit was decided.
+detector_hitScore_t detector_getHitScoreOfLastHit(void) {
+   return hitScoreOfLastHit;
+};
+
+// Returns the sample index (see buffer_getSampleCount()) of the ADC sample
+// that completed the decimated output the last hit was decided on.
+uint64_t detector_getSampleIndexOfLastHit(void) {
+   return sampleIndexOfLastHit;
+};
+
+// Returns the bitmask of frequencies that caused the last hit. In single-hit
+// mode only the bit of detector_getFrequencyNumberOfLastHit() is set.
+detector_hitMask_t detector_getHitMaskOfLastHit(void) {
+   return hitMaskOfLastHit;
+};
+
+// Copy the margins (power above the threshold) of the last hit into the
+// user-provided margins array, indexed by frequency number.
+void detector_getHitMargins(double margins[]) {
+   for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+       margins[i] = hitMargins[i];
+   }
+};
+
 // Ignore all hits. Used to provide some limited invincibility in some game
 // modes. The detector will ignore all hits if the flag is true, otherwise will
 // respond to hits normally.
@@ -239,7 +537,10 @@ void detector_getHitCounts(detector_hitCount_t hitArray[]) {
 // Allows the fudge-factor index to be set externally from the detector.
 // The actual values for fudge-factors is stored in an array found in detector.c
 void detector_setFudgeFactorIndex(uint32_t factorIdx) {
+   if (factorIdx >= FUDGE_FACTOR_COUNT)
+       factorIdx = FUDGE_FACTOR_COUNT - 1;
    fudge_factor_index = factorIdx;
+   fudge_factor = FUDGE_FACTORS[factorIdx];
 };
 
 // Get the fudge facter externally
@@ -247,6 +548,68 @@ uint32_t getFudgeFactorIndex() {
     return fudge_factor_index;
 }
 
+// Returns the fudge factor currently used for the hit threshold.
+uint32_t detector_getFudgeFactor(void) {
+    return fudge_factor;
+}
+
+// Returns the ratio of the strongest band power to the median band power,
+// i.e. the smallest fudge factor that would have reported a hit on these
+// power values. Returns 0 if the median power is 0.
+double detector_getMaxToMedianPowerRatio(const double bandPowers[]) {
+    double sorted[FILTER_FREQUENCY_COUNT];
+    uint16_t frequencies[FILTER_FREQUENCY_COUNT];
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        sorted[i] = bandPowers[i];
+        frequencies[i] = i;
+    }
+    selectionSort(sorted, frequencies, FILTER_FREQUENCY_COUNT);
+    double median = sorted[MEDIAN_POWER_VALUE_INDEX];
+    if (median <= 0.0) return 0.0;
+    return sorted[FILTER_FREQUENCY_COUNT - 1] / median;
+}
+
+// Picks the smallest fudge factor that is at least
+// DETECTOR_CALIBRATION_SAFETY_MARGIN times noiseRatio (the largest max/median
+// power ratio measured with no shooters present), or the largest fudge factor
+// if none is. The index is kept across detector_init(). Returns the index.
+uint32_t detector_calibrateFudgeFactor(double noiseRatio) {
+    uint32_t index = FUDGE_FACTOR_COUNT - 1;
+    for (uint32_t i = 0; i < FUDGE_FACTOR_COUNT; i++) {
+        if (FUDGE_FACTORS[i] >= noiseRatio * DETECTOR_CALIBRATION_SAFETY_MARGIN) {
+            index = i;
+            break;
+        }
+    }
+    detector_setFudgeFactorIndex(index);
+    savedFudgeFactorIndex = index;
+    return index;
+}
+
+
+// Run the hit decision only every period decimated outputs (1 = every output).
+// The filters and power values are still updated on every output. Adds up to
+// (period - 1) * 0.1 ms of detection latency.
+void detector_setDecisionPeriod(uint16_t period) {
+   decisionPeriod = (period == 0) ? 1 : period;
+   // Core 1 owns the output count in AMP mode
+   if (!INTERCORE_AMP_MODE) outputsSinceDecision = 0;
+};
+
+// Report a hit only once a band has been above the threshold for count
+// decisions in a row (1 = on the first one). Adds (count - 1) decision periods
+// of detection latency.
+void detector_setMinConsecutiveDecisions(uint16_t count) {
+   minConsecutiveDecisions = (count == 0) ? 1 : count;
+};
+
+// Selects how samples received while transmitter_running() are handled
+// (see detector_selfTransmitMode_t).
+void detector_setSelfTransmitMode(detector_selfTransmitMode_t mode) {
+   selfTransmitMode = mode;
+   // Core 1 owns the guard in AMP mode, it runs out on its own
+   if (!INTERCORE_AMP_MODE) selfTransmitGuardOutputs = 0;
+};
 
 // Returns the detector invocation count.
 // The count is incremented each time detector is called.
@@ -255,12 +618,213 @@ uint32_t detector_getInvocationCount(void) {
    return invocationCount;
 };
 
-// interrupts are running. If interruptsCurrentlyEnabled = false you can pop
-// values from the ADC buffer without disabling interrupts. If
-// interruptsCurrentlyEnabled = true, do the following:
-// 1. disable interrupts.
-// 2. pop the value from the ADC buffer.
-// 3. re-enable interrupts.
+// Returns true once every decisionPeriod decimated outputs. Call once per
+// decimated output.
+static bool detector_decisionDue() {
+    // Count down the threshold hold after our own shot
+    if (selfTransmitGuardOutputs && !transmitter_running()) selfTransmitGuardOutputs--;
+    if (++outputsSinceDecision < decisionPeriod) return false;
+    outputsSinceDecision = 0;
+    return true;
+}
+
+// Scale a raw ADC value to between -1 and 1 and send it through the filters.
+// Every FILTER_FIR_DECIMATION_FACTOR samples, run the FIR filter, the IIR
+// filters and the power computation. Returns true when new power values exist.
+static bool detector_filterSample(uint32_t rawAdcValue) {
+    static uint32_t invoke_filter = 0;
+
+    // Scale the value to between -1 and 1 and send the value through the filters
+    double scaledAdcValue = (double)(rawAdcValue) / HALF_OF_MAX_ADC_VALUE - 1.0;
+    filter_addNewInput(scaledAdcValue);
+    invoke_filter++;
+
+    // If the filter has been invoked less than 10 times, wait for more input
+    if (invoke_filter != FILTER_FIR_DECIMATION_FACTOR) return false;
+
+    invoke_filter = 0;
+    filter_firFilter();
+    // Iterate through filters for each frequency
+    for (int32_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++) {
+        filter_iirFilter(filterNumber); // Run each of the IIR filters.
+        // Compute the power for each of the filters, at lowest computational cost.
+        // 1st false means do not compute from scratch.
+        // 2nd false means no debug prints.
+        filter_computePower(filterNumber, false, false);
+    }
+
+    // Optional debug statement
+    if (DEBUG_DETECTOR) {
+        // powerValues is only updated at a decision, print the new values
+        double currentPowerValues[FILTER_FREQUENCY_COUNT];
+        filter_getCurrentPowerValues(currentPowerValues);
+        printf("PowerValues {");
+        // Print out power values for debug
+        for (int32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+            printf("%.1f", currentPowerValues[i]);
+            printf((i < FILTER_FREQUENCY_COUNT - 1 ? "," : ""));
+        }
+        printf("}\n");
+    }
+    return true;
+}
+
+// Run the hit decision on the current power values. In multi-hit mode every
+// band has its own lockout, otherwise the single lockoutTimer is used.
+static void detector_decide() {
+    // In multi-hit mode, every band has its own lockout...
+    if (multiHitMode) {
+        double margins[FILTER_FREQUENCY_COUNT];
+        detector_hitMask_t hitMask = detector_hitsCurrentlyDetected(margins);
+        // Lock out each frequency that was just hit
+        for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+            if (hitMask & (1 << band)) lockoutTimer_startFrequency(band);
+        }
+        if (hitMask) {
+            hitLedTimer_enable();   // Start hitLedTimer (line 1)
+            hitLedTimer_start();    // Start hitLedTimer (line 2)
+        }
+    // if the lockoutTimer is not running, run the hit-detection algorithm...
+    } else if (lockoutTimer_running() == false) {
+        // If you detect a hit and the frequency with maximum power is
+        // not an ignored frequency...
+        if (detector_hitCurrentlyDetected()) {
+            lockoutTimer_start();   // Start lockoutTimer
+            hitLedTimer_enable();   // Start hitLedTimer (line 1)
+            hitLedTimer_start();    // Start hitLedTimer (line 2)
+        }
+    // ...otherwise keep the hit-score streaks current
+    } else {
+        detector_updateStreaksLockedOut();
+    }
+}
+
+// Core 0 side of AMP mode. Drains the events sent by core 1 and registers the
+// hits exactly as detector() does when it runs the pipeline itself. Events
+// core 1 sent before it handled the last flush request are dropped.
+static void detector_pollCore1() {
+    interCore_event_t event;
+    // Iterate through every pending event
+    while (interCore_popEvent(&event)) {
+        if (event.sequence != flushSequence) continue;
+        if (event.type == interCore_powerEvent_e) {
+            // Keep the newest power snapshot
+            for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+                core1PowerValues[i] = event.powerValues[i];
+            }
+        } else if (event.type == interCore_hitEvent_e && !ignoreAllHits) {
+            detector_registerHit(event.frequencyNumber, event.powerValues, event.threshold,
+                                 event.consecutiveDecisions);
+            sampleIndexOfLastHit = event.sampleIndex;
+            lockoutTimer_start();   // Start lockoutTimer
+            hitLedTimer_enable();   // Start hitLedTimer (line 1)
+            hitLedTimer_start();    // Start hitLedTimer (line 2)
+        }
+    }
+}
+
+// Entry point of core 1 in AMP mode. Never returns.
+// Drains the ADC samples pushed by the ISR on core 0, runs the filters and the
+// single-hit decision, and sends hit events and power snapshots to core 0.
+// Core 1 keeps its own lockout, counted in decimated outputs, so it does not
+// send the same hit again while core 0 catches up.
+void detector_core1Main(void) {
+    interCore_sample_t samples[DETECTOR_DRAIN_BLOCK_SIZE];
+    uint32_t lockoutOutputs = 0;
+    uint32_t snapshotOutputs = 0;
+    interCore_event_t event;
+    uint64_t sampleIndex = 0;  // Samples received from core 0 so far
+    uint32_t sequence = 0;  // Flush requests handled so far, sent with every event
+
+    while (true) {
+        // Flush requested by core 0: drop the pending samples and start the
+        // pipeline over
+        if (interCore_popRequest(&event) && event.type == interCore_flushEvent_e) {
+            sequence = event.sequence;
+            uint32_t dropped;
+            while ((dropped = interCore_popSamples(samples, DETECTOR_DRAIN_BLOCK_SIZE)) > 0) {
+                sampleIndex += dropped;
+            }
+            filter_init();  // Static storage, safe to repeat
+            detector_resetPipeline();
+            lockoutOutputs = 0;
+            continue;
+        }
+        uint32_t count = interCore_popSamples(samples, DETECTOR_DRAIN_BLOCK_SIZE);
+        // Drop the block if our own shot is on the air (skip mode)
+        if (detector_checkSelfTransmit()) {
+            sampleIndex += count;
+            continue;
+        }
+        // Iterate through the block of samples
+        for (uint32_t i = 0; i < count; i++, sampleIndex++) {
+            if (!detector_filterSample(samples[i])) continue;
+
+            // Send a power snapshot every so often
+            if (++snapshotOutputs >= DETECTOR_CORE1_SNAPSHOT_OUTPUTS) {
+                snapshotOutputs = 0;
+                event.type = interCore_powerEvent_e;
+                event.sequence = sequence;
+                event.frequencyNumber = 0;
+                event.threshold = 0.0;
+                event.sampleIndex = sampleIndex;
+                filter_getCurrentPowerValues(event.powerValues);
+                interCore_pushEvent(&event);
+            }
+
+            bool lockedOut = (lockoutOutputs > 0);
+            if (lockedOut) lockoutOutputs--;
+
+            // Only decide every decisionPeriod decimated outputs
+            if (!detector_decisionDue()) continue;
+
+            // Keep the streaks current, but skip the decision while locked out
+            if (lockedOut) {
+                detector_updateStreaksLockedOut();
+                continue;
+            }
+            double base_line = detector_computeBaseLine();
+            detector_updateStreaks(base_line);
+
+            // Send the strongest eligible band to core 0
+            int32_t hitIndex = detector_findStrongestHit(base_line);
+            if (hitIndex >= 0) {
+                event.type = interCore_hitEvent_e;
+                event.sequence = sequence;
+                event.frequencyNumber = playerFrequencies_sorted[hitIndex];
+                event.consecutiveDecisions = aboveThresholdStreaks[event.frequencyNumber];
+                event.threshold = base_line;
+                event.sampleIndex = sampleIndex;
+                for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+                    event.powerValues[band] = powerValues[band];
+                }
+                if (interCore_pushEvent(&event)) lockoutOutputs = DETECTOR_CORE1_LOCKOUT_OUTPUTS;
+            }
+        }
+    }
+}
+
+// Start the filter and detector pipeline on core 1 (AMP mode). Only the first
+// call initializes the filters and the inter-core rings and starts core 1;
+// they belong to core 1 from then on, so later calls do nothing.
+void detector_startCore1(void) {
+    if (core1Started) return;
+    filter_init();
+    interCore_init();
+    core1Started = true;
+    interCore_startCore1(detector_core1Main);
+}
+
+// Copy the newest power snapshot sent by core 1 into powerValues (AMP mode).
+void detector_getCore1PowerValues(double powerValues[]) {
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+        powerValues[i] = core1PowerValues[i];
+    }
+}
+
+// interrupts are running. The ADC buffer is a lock-free single-producer/
+// single-consumer ring, so the completed sample blocks are processed in place
+// (buffer_acquireBlock()) without disabling interrupts in either case.
 // Ignore hits on frequencies specified with detector_setIgnoredFrequencies().
 // Assumption: draining the ADC buffer occurs faster than it can fill.
 void detector(bool interruptsCurrentlyEnabled){
@@ -268,63 +832,35 @@ void detector(bool interruptsCurrentlyEnabled){
    // Increment the invocation count
    invocationCount++;
 
+   // In AMP mode core 1 runs the pipeline, just collect its results
+   if (INTERCORE_AMP_MODE) {
+       detector_pollCore1();
+       return;
+   }
+
    // Query the ADC buffer to determine how many elements it contains.
    uint32_t elementCount = buffer_elements();
-   static uint32_t invoke_filter = 0;
-
-
-   // Repeat the following steps elementCount times
-   for (int32_t i = 0; i < elementCount; i++){
-       // If interrupts are currently enabled...
-       if (interruptsCurrentlyEnabled) {
-           // Temporarily disable interrupts to pop a value from the buffer
-           interrupts_disableArmInts();
-           buffer_data_t rawAdcValue = buffer_pop();
-           interrupts_enableArmInts();
-
-
-           // Scale the value to between -1 and 1 and send the value through the filters
-           double scaledAdcValue = (double)(rawAdcValue) / HALF_OF_MAX_ADC_VALUE - 1.0;
-           filter_addNewInput(scaledAdcValue);
-           invoke_filter++;
-
-           // If the filter has been invoked more than 10 times...
-           if (invoke_filter == FILTER_FREQUENCY_COUNT){
-               invoke_filter = 0;
-               filter_firFilter();
-               // Iterate through filters for each frequency
-               for (int32_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++) {
-                    filter_iirFilter(filterNumber); // Run each of the IIR filters.
-                    // Compute the power for each of the filters, at lowest computational cost.
-                    // 1st false means do not compute from scratch.
-                    // 2nd false means no debug prints.
-                    filter_computePower(filterNumber, false, false);
-                }
-
-                // Optional debug statement
-                if (DEBUG_DETECTOR) {
-                    printf("PowerValues {");
-                    // Print out power values for debug
-                    for (int32_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
-                        printf("%d", powerValues[i]);
-                        printf((i < FILTER_FREQUENCY_COUNT - 1 ? "," : ""));
-                    }
-                    printf("}\n");
-                }
-
-               // if the lockoutTimer is not running, run the hit-detection algorithm...
-               if (lockoutTimer_running() == false) {
-
-                   // If you detect a hit and the frequency with maximum power is
-                   // not an ignored frequency...
-                   if (detector_hitCurrentlyDetected()) {
-                        lockoutTimer_start();   // Start lockoutTimer
-                        hitLedTimer_enable();   // Start hitLedTimer (line 1)
-                        hitLedTimer_start();    // Start hitLedTimer (line 2)
-                   }
-               }
+   // Drop the samples without filtering if our own shot is on the air (skip mode)
+   bool skipSamples = detector_checkSelfTransmit();
+
+
+   // Process the completed blocks of samples in place. The buffer is a
+   // lock-free single-producer/single-consumer ring, so interrupts stay enabled.
+   const buffer_data_t *block;
+   uint64_t firstIndex;
+   uint32_t count;
+   while (elementCount > 0 && (count = buffer_acquireBlock(&block, &firstIndex)) > 0) {
+       elementCount = (count < elementCount) ? elementCount - count : 0;
+       if (!skipSamples) {
+           // Iterate through the block of samples
+           for (uint32_t i = 0; i < count; i++) {
+               // Send the value through the filters. Once a new decimated output
+               // has been computed, decide every decisionPeriod outputs
+               currentSampleIndex = firstIndex + i;
+               if (detector_filterSample(block[i]) && detector_decisionDue()) detector_decide();
            }
        }
+       buffer_releaseBlock(count);
    }
 }
 
@@ -355,6 +891,9 @@ void detector_runTest(void) {
     // Print out result
     if (detector_hitCurrentlyDetected()) printf("Hit detected at Frequency %d\n", frequencyNumberOfLastHit);
     else printf("Hit not detected\n");
+    detector_hitScore_t score = detector_getHitScoreOfLastHit();
+    printf("Hit score: ratio %.1f (expected 60.0), margin %.1f (expected 500.0), %d decision(s)\n",
+           score.powerToMedianRatio, score.margin, score.consecutiveDecisions);
   
 
     uint32_t power_Values2[FILTER_FREQUENCY_COUNT] = QUEUE_2;
@@ -377,5 +916,84 @@ void detector_runTest(void) {
     else printf("Hit not detected\n");
 
 
+    // Multi-hit: two shooters above the threshold on frequencies 2 and 8
+    uint32_t power_Values4[FILTER_FREQUENCY_COUNT] = QUEUE_4;
+    for(int i = 0; i < FILTER_FREQUENCY_COUNT; i++){
+        filter_setCurrentPowerValue(i, power_Values4[i]);
+    }
+    double margins[FILTER_FREQUENCY_COUNT];
+    detector_hitMask_t hitMask = detector_hitsCurrentlyDetected(margins);
+    printf("Multi-hit mask 0x%03X (expected 0x104)\n", hitMask);
+    // A following decision without a hit must leave the hit for the consumer
+    for(int i = 0; i < FILTER_FREQUENCY_COUNT; i++){
+        filter_setCurrentPowerValue(i, DETECTOR_TEST_FLAT_POWER);
+    }
+    detector_hitsCurrentlyDetected(margins);
+    printf("Multi-hit still flagged after a quiet decision: %s (expected yes)\n",
+           detector_hitPreviouslyDetected() ? "yes" : "no");
+    detector_clearHit();
+
+    // With a minimum of 2, the first decision above the threshold is no hit
+    detector_setMinConsecutiveDecisions(2);
+    for(int i = 0; i < FILTER_FREQUENCY_COUNT; i++){
+        filter_setCurrentPowerValue(i, power_Values[i]);
+    }
+    bool firstDecisionHit = detector_hitCurrentlyDetected();
+    bool secondDecisionHit = detector_hitCurrentlyDetected();
+    score = detector_getHitScoreOfLastHit();
+    printf("Minimum of 2 decisions: hit on the 1st %s, on the 2nd %s, %d decision(s) "
+           "(expected no, yes, 2)\n", firstDecisionHit ? "yes" : "no",
+           secondDecisionHit ? "yes" : "no", score.consecutiveDecisions);
+    detector_setMinConsecutiveDecisions(DETECTOR_DEFAULT_MIN_CONSECUTIVE_DECISIONS);
+
     printf("TERMINATING: Detector_runTest()\n");
-};
\ No newline at end of file
+};
+
+// Times the filter update and the hit decision over
+// DETECTOR_DECISION_TEST_OUTPUTS decimated outputs, then prints for each
+// decision period the added worst-case detection latency and the share of
+// detector CPU time saved compared to deciding on every output.
+// Does not need interrupts. Re-initializes the filters and the detector.
+void detector_runDecisionRateTest(void) {
+    printf("STARTING: detector_runDecisionRateTest()\n");
+    filter_init();
+    detector_init();
+    bool ignored_frequencies[FILTER_FREQUENCY_COUNT] = {false};
+    detector_setIgnoredFrequencies(ignored_frequencies);
+    intervalTimer_init(DETECTOR_DECISION_TEST_TIMER);
+
+    // Time the filters and power updates (10 samples per decimated output)
+    intervalTimer_reset(DETECTOR_DECISION_TEST_TIMER);
+    intervalTimer_start(DETECTOR_DECISION_TEST_TIMER);
+    for (uint32_t i = 0; i < DETECTOR_DECISION_TEST_OUTPUTS * FILTER_FIR_DECIMATION_FACTOR; i++) {
+        detector_filterSample(i & 0xFFF);
+    }
+    intervalTimer_stop(DETECTOR_DECISION_TEST_TIMER);
+    double filterSeconds = intervalTimer_getTotalDurationInSeconds(DETECTOR_DECISION_TEST_TIMER);
+
+    // Time the hit decision alone
+    intervalTimer_reset(DETECTOR_DECISION_TEST_TIMER);
+    intervalTimer_start(DETECTOR_DECISION_TEST_TIMER);
+    for (uint32_t i = 0; i < DETECTOR_DECISION_TEST_OUTPUTS; i++) {
+        detector_hitCurrentlyDetected();
+    }
+    intervalTimer_stop(DETECTOR_DECISION_TEST_TIMER);
+    double decisionSeconds = intervalTimer_getTotalDurationInSeconds(DETECTOR_DECISION_TEST_TIMER);
+
+    printf("per output: filters %.2f us, decision %.2f us\n",
+           filterSeconds / DETECTOR_DECISION_TEST_OUTPUTS * 1e6,
+           decisionSeconds / DETECTOR_DECISION_TEST_OUTPUTS * 1e6);
+
+    // Report the tradeoff for each period
+    uint16_t periods[DETECTOR_DECISION_PERIOD_COUNT] = DETECTOR_DECISION_PERIODS;
+    for (uint16_t i = 0; i < DETECTOR_DECISION_PERIOD_COUNT; i++) {
+        double latencyMs = (periods[i] - 1) * DETECTOR_DECIMATED_OUTPUT_PERIOD_MS;
+        double savedSeconds = decisionSeconds * (1.0 - 1.0 / periods[i]);
+        double savedPercent = savedSeconds / (filterSeconds + decisionSeconds) * 100;
+        printf("period %2d: +%.1f ms worst-case latency, %.1f%% detector CPU saved\n",
+               periods[i], latencyMs, savedPercent);
+    }
+
+    detector_init();
+    printf("TERMINATING: detector_runDecisionRateTest()\n");
+}
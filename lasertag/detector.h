@@ -16,9 +16,33 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 
 typedef uint16_t detector_hitCount_t;
 
+// Bitmask of frequency numbers. Bit i is set for frequency number i.
+typedef uint16_t detector_hitMask_t;
+
+// Confidence of a reported hit.
+typedef struct {
+  double powerToMedianRatio; // Hit band power divided by the median band power.
+  double margin;             // Hit band power minus the hit threshold.
+  uint16_t consecutiveDecisions; // Decisions in a row with the hit band above
+                                 // the threshold, including the deciding one.
+} detector_hitScore_t;
+
+// What the detector does while our own transmitter is firing a shot.
+typedef enum {
+  detector_selfTransmitProcess_e, // Process samples as usual (default).
+  detector_selfTransmitFreeze_e,  // Keep filtering, hold the last threshold and
+                                  // never report our own frequency.
+  detector_selfTransmitSkip_e     // Drop the samples without filtering. No hit
+                                  // can be detected during the shot, and the
+                                  // filters resume across the gap without a
+                                  // reset. For measurements, not for the game.
+} detector_selfTransmitMode_t;
+
 // Initialize the detector module.
 // By default, all frequencies are considered for hits.
 // Assumes the filter module is initialized previously.
+// Once core 1 runs (AMP mode), its pipeline state is reset by a flush request
+// instead of being written from core 0.
 void detector_init(void);
 
 // Flush the array buffer values to avoid counting hits while in invincibility mode
@@ -31,25 +55,73 @@ void detector_setIgnoredFrequencies(bool freqArray[]);
 
 // Runs the entire detector: decimating FIR-filter, IIR-filters,
 // power-computation, hit-detection. If interruptsCurrentlyEnabled = true,
-// interrupts are running. If interruptsCurrentlyEnabled = false you can pop
-// values from the ADC buffer without disabling interrupts. If
-// interruptsCurrentlyEnabled = true, do the following:
-// 1. disable interrupts.
-// 2. pop the value from the ADC buffer.
-// 3. re-enable interrupts.
+// interrupts are running. The ADC buffer is a lock-free single-producer/
+// single-consumer ring, so the completed sample blocks are processed in place
+// (buffer_acquireBlock()) without disabling interrupts in either case.
 // Ignore hits on frequencies specified with detector_setIgnoredFrequencies().
 // Assumption: draining the ADC buffer occurs faster than it can fill.
 void detector(bool interruptsCurrentlyEnabled);
 
+// Entry point of core 1 in AMP mode (see interCore.h). Never returns.
+// Drains the ADC samples pushed by the ISR on core 0, runs the filters and the
+// single-hit decision, and sends hit events and power snapshots to core 0.
+// On core 0, detector() then only registers the hits sent by core 1.
+void detector_core1Main(void);
+
+// Start the filter and detector pipeline on core 1 (AMP mode). Only the first
+// call initializes the filters and the inter-core rings and starts core 1;
+// they belong to core 1 from then on, so later calls do nothing. Call after
+// detector_init(); later detector_init() calls reset core 1 through a request.
+void detector_startCore1(void);
+
+// Copy the newest power snapshot sent by core 1 into powerValues (AMP mode).
+void detector_getCore1PowerValues(double powerValues[]);
+
 // Detect a hit
 bool detector_hitCurrentlyDetected();
 
+// Multi-hit detection. Evaluates every band in one pass instead of stopping at
+// the strongest one. Ignored frequencies and frequencies that are still locked
+// out (see lockoutTimer_frequencyRunning()) are never reported. Each reported
+// band is counted in the hit array. margins[] is indexed by frequency number and
+// receives the power above the threshold for every band (negative if below).
+// Returns a bitmask of the bands that were hit, 0 if none.
+detector_hitMask_t detector_hitsCurrentlyDetected(double margins[]);
+
+// Enable or disable multi-hit mode. When enabled, detector() uses
+// detector_hitsCurrentlyDetected() and a separate lockout per frequency
+// instead of the single global lockoutTimer, so concurrent shooters are all
+// credited. Disabled by default. Core 1 only makes single-hit decisions, so in
+// AMP mode enabling it is refused. Returns false if refused.
+bool detector_setMultiHitMode(bool enable);
+
 // Returns true if a hit was detected.
 bool detector_hitPreviouslyDetected(void);
 
+// Returns the sample index (see buffer_getSampleCount()) of the ADC sample
+// that completed the decimated output the last hit was decided on. The
+// detection latency is buffer_getSampleCount() minus this index, in 10 us ISR
+// ticks. In AMP mode the index counts the samples core 1 has received.
+uint64_t detector_getSampleIndexOfLastHit(void);
+
+// Returns the bitmask of frequencies that caused the last hit. In single-hit
+// mode only the bit of detector_getFrequencyNumberOfLastHit() is set.
+detector_hitMask_t detector_getHitMaskOfLastHit(void);
+
+// Copy the margins (power above the threshold) of the last hit into the
+// user-provided margins array, indexed by frequency number.
+void detector_getHitMargins(double margins[]);
+
 // Returns the frequency number that caused the hit.
 uint16_t detector_getFrequencyNumberOfLastHit(void);
 
+// Returns the score of the band reported by
+// detector_getFrequencyNumberOfLastHit(), as taken when the hit was decided.
+// consecutiveDecisions is at least the minimum set with
+// detector_setMinConsecutiveDecisions(); it is higher for a band that was
+// already above the threshold during a lockout.
+detector_hitScore_t detector_getHitScoreOfLastHit(void);
+
 // Clear the detected hit once you have accounted for it.
 void detector_clearHit(void);
 
@@ -70,6 +142,37 @@ void detector_setFudgeFactorIndex(uint32_t factorIdx);
 // Get the fudge facter externally
 uint32_t getFudgeFactorIndex(void);
 
+// Returns the fudge factor currently used for the hit threshold.
+uint32_t detector_getFudgeFactor(void);
+
+// Returns the ratio of the strongest band power to the median band power,
+// i.e. the smallest fudge factor that would have reported a hit on these
+// power values. Returns 0 if the median power is 0.
+double detector_getMaxToMedianPowerRatio(const double bandPowers[]);
+
+// Picks the smallest fudge factor that is safely above noiseRatio (the largest
+// max/median power ratio measured with no shooters present) and uses it from
+// now on, including after detector_init(). Returns the fudge-factor index.
+uint32_t detector_calibrateFudgeFactor(double noiseRatio);
+
+// Run the hit decision only every period decimated outputs (1 = every output,
+// the default). The filters and power values are still updated on every
+// output. Adds up to (period - 1) * 0.1 ms of detection latency.
+void detector_setDecisionPeriod(uint16_t period);
+
+// Report a hit only once a band has been above the threshold for count
+// decisions in a row (1 = on the first one, the default). Adds (count - 1)
+// decision periods of detection latency, so a short noise spike needs to last
+// longer to be reported as a hit.
+void detector_setMinConsecutiveDecisions(uint16_t count);
+
+// Selects how samples received while transmitter_running() are handled
+// (see detector_selfTransmitMode_t). In the freeze and skip modes the hit
+// threshold computed before the shot is held, and our own frequency is never
+// reported, until the power windows hold only post-shot samples again.
+// Don't enable this while the transmitter runs in continuous mode.
+void detector_setSelfTransmitMode(detector_selfTransmitMode_t mode);
+
 // Returns the detector invocation count.
 // The count is incremented each time detector is called.
 // Used for run-time statistics.
@@ -85,4 +188,9 @@ uint32_t detector_getInvocationCount(void);
 // should detect a hit on the first set and not detect a hit on the second.
 void detector_runTest(void);
 
+// Times the filter update and the hit decision, then prints for decision
+// periods 1, 4, 8 and 16 the added worst-case detection latency and the share
+// of detector CPU time saved. Does not need interrupts.
+void detector_runDecisionRateTest(void);
+
 #endif /* DETECTOR_H_ */
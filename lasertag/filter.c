@@ -16,6 +16,15 @@
 #define IIR_B_COEFFICIENTS_COUNT 11
 #define FIR_COEFFICIENTS_COUNT 81
 
+// Capacities of the mirrored history queues: powers of two that hold at least
+// the X_QUEUE_SIZE, Y_QUEUE_SIZE and Z_QUEUE_SIZE newest values.
+#define X_QUEUE_CAPACITY 128
+#define Y_QUEUE_CAPACITY 16
+#define Z_QUEUE_CAPACITY 16
+
+// Zeros pushed per block when the queues are initialized.
+#define ZERO_BLOCK_SIZE 200
+
 #define POWER_200_SIZE 200
 #define STRING_LENGTH_20 20
 
@@ -24,6 +33,18 @@ static queue_t yQueue;
 static queue_t zQueues[Z_QUEUE_SIZE];
 static queue_t outputQueues[OUTPUT_QUEUE_SIZE];
 
+// Storage for all of the queues above, sized at compile time so filter_init()
+// never touches the heap and can be called again on restart without leaking.
+// Every array is a multiple of the cache line size, so each queue starts on a
+// line of its own and the history queues used per sample sit next to each
+// other. Mirrored queues hold every value twice.
+static struct {
+  queue_data_t x[2 * X_QUEUE_CAPACITY];
+  queue_data_t y[2 * Y_QUEUE_CAPACITY];
+  queue_data_t z[Z_QUEUE_SIZE][2 * Z_QUEUE_CAPACITY];
+  queue_data_t output[OUTPUT_QUEUE_SIZE][OUTPUT_QUEUE_DATA_SIZE];
+} filterArena __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+
 static double powerArray[POWER_ARRAY_SIZE];
 
 const static double fir_coeffs[FIR_COEFFICIENTS_COUNT] = {
@@ -219,24 +240,30 @@ const static double
          4.5464330574094585e-09, 0.0000000000000000e+00,
          -9.0928661148189176e-10}};
 
+// Pushes count zeros into q, a block at a time.
+static void fillQueueWithZeros(queue_t *q, uint32_t count) {
+  static const queue_data_t zeros[ZERO_BLOCK_SIZE];
+  while (count > 0) {
+    uint32_t n = count < ZERO_BLOCK_SIZE ? count : ZERO_BLOCK_SIZE;
+    queue_overwritePushBlock(q, zeros, n);
+    count -= n;
+  }
+}
+
 // Initialize xQueue
 void initXQueue() {
   // Init xQueue
-  queue_init(&xQueue, X_QUEUE_SIZE, "xQueue");
+  queue_initMirroredStatic(&xQueue, filterArena.x, X_QUEUE_CAPACITY, "xQueue");
   // Fill queue with 0's
-  for (int32_t i = 0; i < X_QUEUE_SIZE; i++) {
-    queue_overwritePush(&xQueue, 0);
-  }
+  fillQueueWithZeros(&xQueue, X_QUEUE_SIZE);
 }
 
 // Initialize yQueue
 void initYQueue() {
   // Init yQueue
-  queue_init(&yQueue, Y_QUEUE_SIZE, "yQueue");
+  queue_initMirroredStatic(&yQueue, filterArena.y, Y_QUEUE_CAPACITY, "yQueue");
   // Fill queue with 0's
-  for (int32_t i = 0; i < Y_QUEUE_SIZE; i++) {
-    queue_overwritePush(&yQueue, 0);
-  }
+  fillQueueWithZeros(&yQueue, Y_QUEUE_SIZE);
 }
 
 // Initialize zQueue
@@ -248,12 +275,11 @@ void initZQueue() {
     char name[STRING_LENGTH_20];
     sprintf(name, "zQueue%d", i);
     // Init zQueue
-    queue_init(&zQueues[i], Z_QUEUE_SIZE, name);
+    queue_initMirroredStatic(&zQueues[i], filterArena.z[i], Z_QUEUE_CAPACITY,
+                             name);
 
     // Fill queue with 0's
-    for (int32_t j = 0; j < Z_QUEUE_FILTER_SIZE; j++) {
-      queue_overwritePush(&zQueues[i], 0);
-    }
+    fillQueueWithZeros(&zQueues[i], Z_QUEUE_FILTER_SIZE);
   }
 }
 
@@ -265,11 +291,10 @@ void initOutputQueue() {
     char name[STRING_LENGTH_20];
     sprintf(name, "outputQueue%d", i);
     // Init outputQueues
-    queue_init(&outputQueues[i], OUTPUT_QUEUE_DATA_SIZE, name);
+    queue_initStatic(&outputQueues[i], filterArena.output[i],
+                     OUTPUT_QUEUE_DATA_SIZE, name);
     // Fill queue with 0's
-    for (int32_t j = 0; j < OUTPUT_QUEUE_DATA_SIZE; j++) {
-      queue_overwritePush(&outputQueues[i], 0);
-    }
+    fillQueueWithZeros(&outputQueues[i], OUTPUT_QUEUE_DATA_SIZE);
   }
 }
 
@@ -301,10 +326,11 @@ void filter_addNewInput(double x) { queue_overwritePush(&xQueue, x); }
 // Output is returned and is also pushed on to yQueue.
 double filter_firFilter() {
   double sum = 0;
+  // Newest FIR_COEFFICIENTS_COUNT inputs as one array (newest last)
+  const queue_data_t *x = queue_window(&xQueue, FIR_COEFFICIENTS_COUNT);
   // Iterate through xQueue
   for (int32_t i = 0; i < FIR_COEFFICIENTS_COUNT; i++) {
-    sum += queue_readElementAt(&xQueue, FIR_COEFFICIENTS_COUNT - 1 - i) *
-           fir_coeffs[i];
+    sum += x[FIR_COEFFICIENTS_COUNT - 1 - i] * fir_coeffs[i];
   }
   // Push sum to yQueue
   queue_overwritePush(&yQueue, sum);
@@ -320,17 +346,21 @@ double filter_iirFilter(uint16_t filterNumber) {
   double sumZ = 0;
   double sumYminusZ = 0;
 
+  // Newest inputs and outputs as arrays (newest last)
+  const queue_data_t *y = queue_window(&yQueue, IIR_B_COEFFICIENTS_COUNT);
+  const queue_data_t *z =
+      queue_window(&zQueues[filterNumber], IIR_A_COEFFICIENTS_COUNT);
+  const double *b = iir_b_coeffs[filterNumber];
+  const double *a = iir_a_coeffs[filterNumber];
+
   // Iterate through y-queue
   for (int32_t k = 0; k < IIR_B_COEFFICIENTS_COUNT; k++) {
-    sumY += queue_readElementAt(&yQueue, IIR_B_COEFFICIENTS_COUNT - 1 - k) *
-            iir_b_coeffs[filterNumber][k];
+    sumY += y[IIR_B_COEFFICIENTS_COUNT - 1 - k] * b[k];
   }
 
   // Iterate through z-queue instance
   for (int32_t k = 0; k < IIR_A_COEFFICIENTS_COUNT; k++) {
-    sumZ += queue_readElementAt(&zQueues[filterNumber],
-                                IIR_A_COEFFICIENTS_COUNT - 1 - k) *
-            iir_a_coeffs[filterNumber][k];
+    sumZ += z[IIR_A_COEFFICIENTS_COUNT - 1 - k] * a[k];
   }
 
   // Push new values to zQueue and outputQueues
@@ -131,6 +131,9 @@ void game_twoTeamTag(void) {
     if (DEBUG_GAME) printf("TEAM A\n"); // Optional debug
   }
   detector_setIgnoredFrequencies(ignoredFrequencies); // Set ignored frequencies
+  // Hold the threshold and ignore our own frequency while we shoot, we can
+  // still be hit
+  detector_setSelfTransmitMode(detector_selfTransmitFreeze_e);
 
   // Optional global debug
   if (DEBUG_GAME) {
@@ -152,7 +155,8 @@ void game_twoTeamTag(void) {
   interrupts_startArmPrivateTimer();  // Start the private ARM timer running.
   intervalTimer_reset(ISR_CUMULATIVE_TIMER); // Used to measure ISR execution time.
   intervalTimer_reset(TOTAL_RUNTIME_TIMER); // Used to measure total program execution time.
-  intervalTimer_reset(MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
+  if (RUNNING_MODES_MAIN_LOOP_TIMED)
+    intervalTimer_reset(MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
   intervalTimer_start(TOTAL_RUNTIME_TIMER);   // Start measuring total execution time.
   interrupts_enableArmInts(); // ARM will now see interrupts after this.
   lockoutTimer_start(); // Ignore erroneous hits at startup (when all power
@@ -164,10 +168,12 @@ void game_twoTeamTag(void) {
   while ((!(buttons_read() & BUTTONS_BTN3_MASK)) &&
          hitCount < MAX_NUMBER_HITS) { // Run until you detect BTN3 pressed.
 
+    isr_runBottomHalf(); // Run the tick functions for the elapsed interrupts.
     transmitter_setFrequencyNumber(runningModes_getFrequencySetting());    // Read the switches and switch
                                                 // frequency as required.
-    intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
-                                                // doing something.
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
+                                                  // doing something.
     // Run filters, compute power, run hit-detection.
     if (!invincibilityTimer_running()) detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
     
@@ -229,8 +235,10 @@ void game_twoTeamTag(void) {
           }
       }
     }
-    intervalTimer_stop(
-        MAIN_CUMULATIVE_TIMER); // All done with actual processing.
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_stop(
+          MAIN_CUMULATIVE_TIMER); // All done with actual processing.
+    runningModes_reportBufferOverflows(false); // LEDs only, no console here.
   }
 
   trigger_disable();  // Disable the trigger
@@ -19,9 +19,6 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // Need to init things.
 void hitLedTimer_init();
 
-// Standard tick function.
-void hitLedTimer_tick();
-
 // Calling this starts the timer.
 void hitLedTimer_start();
 
@@ -42,7 +39,7 @@ void hitLedTimer_enable();
 
 // Runs a visual test of the hit LED until BTN3 is pressed.
 // The test continuously blinks the hit-led on and off.
-// Depends on the interrupt handler to call tick function.
+// Depends on the interrupt handler to call timerService_tick().
 void hitLedTimer_runTest();
 
 // Return true if the game is over
@@ -0,0 +1,311 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "interCore.h"
+#include "filter.h"
+#include "queueSpsc.h"
+
+#ifdef ZYBO_BOARD
+#include "intervalTimer.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// Sample ring (core 0 -> core 1)
+static queueSpsc_t sampleRing;
+static interCore_sample_t sampleData[INTERCORE_SAMPLE_RING_SIZE] __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+
+// Event ring (core 1 -> core 0)
+static queueSpsc_t eventRing;
+static interCore_event_t eventData[INTERCORE_EVENT_RING_SIZE] __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+
+// Request ring (core 0 -> core 1)
+static queueSpsc_t requestRing;
+static interCore_event_t requestData[INTERCORE_REQUEST_RING_SIZE] __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+
+/////////////////////////
+/// CORE 1 START (AMP) //
+/////////////////////////
+
+#ifdef ZYBO_BOARD
+
+// After reset, core 1 sleeps in the boot ROM (WFE) until an address is written
+// here and an event is signaled.
+#define INTERCORE_CPU1_START_ADDRESS 0xFFFFFFF0
+#define INTERCORE_CORE1_STACK_SIZE 0x4000
+#define INTERCORE_STRINGIFY(x) #x
+#define INTERCORE_TO_STRING(x) INTERCORE_STRINGIFY(x)
+
+// Read by the core 1 trampoline, so they are not static.
+uint8_t interCore_core1Stack[INTERCORE_CORE1_STACK_SIZE] __attribute__((aligned(8)));
+uint32_t interCore_core1Ttbr0;    // Core 0 translation table, shared with core 1
+void (*interCore_core1Entry)(void); // C function core 1 runs
+
+// First code run by core 1. Sets up a stack, enables the VFP (the filters use
+// doubles), joins the SCU coherency domain, shares core 0's translation table,
+// enables the MMU and caches, then calls interCore_core1Entry.
+static void __attribute__((naked)) interCore_core1Trampoline(void) {
+    __asm__ volatile(
+        "ldr sp, =interCore_core1Stack + " INTERCORE_TO_STRING(INTERCORE_CORE1_STACK_SIZE) "\n"
+        // Enable access to CP10/CP11 and turn on the VFP.
+        "mrc p15, 0, r0, c1, c0, 2\n"
+        "orr r0, r0, #(0xF << 20)\n"
+        "mcr p15, 0, r0, c1, c0, 2\n"
+        "isb\n"
+        "mov r0, #0x40000000\n"
+        "vmsr fpexc, r0\n"
+        // ACTLR.SMP: take part in SCU coherency with core 0.
+        "mrc p15, 0, r0, c1, c0, 1\n"
+        "orr r0, r0, #(1 << 6)\n"
+        "mcr p15, 0, r0, c1, c0, 1\n"
+        // Invalidate the L1 D-cache by set/way (4 ways, 256 sets, 32-byte lines).
+        "mov r1, #0\n"
+        "1:\n"
+        "mov r2, #0\n"
+        "2:\n"
+        "orr r0, r1, r2\n"
+        "mcr p15, 0, r0, c7, c6, 2\n"
+        "add r2, r2, #(1 << 5)\n"
+        "cmp r2, #(256 << 5)\n"
+        "bne 2b\n"
+        "adds r1, r1, #(1 << 30)\n"
+        "bne 1b\n"
+        // Use core 0's translation table, all domains as clients.
+        "ldr r0, =interCore_core1Ttbr0\n"
+        "ldr r0, [r0]\n"
+        "mcr p15, 0, r0, c2, c0, 0\n"
+        "ldr r0, =0x55555555\n"
+        "mcr p15, 0, r0, c3, c0, 0\n"
+        // Invalidate TLBs and I-cache.
+        "mov r0, #0\n"
+        "mcr p15, 0, r0, c8, c7, 0\n"
+        "mcr p15, 0, r0, c7, c5, 0\n"
+        "dsb\n"
+        "isb\n"
+        // Enable the MMU, D-cache and I-cache.
+        "mrc p15, 0, r0, c1, c0, 0\n"
+        "orr r0, r0, #0x1000\n"
+        "orr r0, r0, #0x5\n"
+        "mcr p15, 0, r0, c1, c0, 0\n"
+        "dsb\n"
+        "isb\n"
+        // Run the entry function. Sleep forever if it ever returns.
+        "ldr r0, =interCore_core1Entry\n"
+        "ldr r0, [r0]\n"
+        "blx r0\n"
+        "3:\n"
+        "wfe\n"
+        "b 3b\n");
+}
+
+// Start core 1 running entry(). Core 1 must never return on the board.
+void interCore_startCore1(void (*entry)(void)) {
+    interCore_core1Entry = entry;
+    interCore_core1Ttbr0 = mfcp(XREG_CP15_TTBR0);
+    // Core 1 starts with its caches off, so everything it reads before joining
+    // the coherency domain must be in memory.
+    Xil_DCacheFlush();
+    Xil_Out32(INTERCORE_CPU1_START_ADDRESS, (u32)(UINTPTR)interCore_core1Trampoline);
+    dsb();
+    __asm__ volatile("sev");
+}
+
+#else
+
+// Run the core 1 entry function on the host thread.
+static void *interCore_core1Thread(void *arg) {
+    void (*entry)(void) = (void (*)(void))arg;
+    entry();
+    return NULL;
+}
+
+// Start core 1 running entry(). On a host, core 1 is a pthread.
+void interCore_startCore1(void (*entry)(void)) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, interCore_core1Thread, (void *)entry) != 0) {
+        printf("ERROR in interCore_startCore1(): Unable to create thread.\n");
+        return;
+    }
+    pthread_detach(thread);
+}
+
+#endif
+
+/////////////////////
+/// MAIN FUNCTIONS //
+/////////////////////
+
+// Reset all rings to empty. Call on core 0 before interCore_startCore1().
+void interCore_init() {
+    queueSpsc_init(&sampleRing, sampleData, INTERCORE_SAMPLE_RING_SIZE,
+                   sizeof(interCore_sample_t), "interCoreSamples");
+    queueSpsc_init(&eventRing, eventData, INTERCORE_EVENT_RING_SIZE,
+                   sizeof(interCore_event_t), "interCoreEvents");
+    queueSpsc_init(&requestRing, requestData, INTERCORE_REQUEST_RING_SIZE,
+                   sizeof(interCore_event_t), "interCoreRequests");
+}
+
+// Producer side of the sample ring (core 0 ISR). Returns false and counts a
+// dropped sample if the ring is full.
+bool interCore_pushSample(interCore_sample_t sample) {
+    return queueSpsc_push(&sampleRing, &sample);
+}
+
+// Consumer side of the sample ring (core 1). Copies up to max samples into dst
+// and returns the number copied.
+uint32_t interCore_popSamples(interCore_sample_t dst[], uint32_t max) {
+    return queueSpsc_popBlock(&sampleRing, dst, max);
+}
+
+// Producer side of the event ring (core 1). Returns false if the ring is full.
+bool interCore_pushEvent(const interCore_event_t *event) {
+    return queueSpsc_push(&eventRing, event);
+}
+
+// Consumer side of the event ring (core 0). Returns false if the ring is empty.
+bool interCore_popEvent(interCore_event_t *event) {
+    return queueSpsc_pop(&eventRing, event);
+}
+
+// Producer side of the request ring (core 0). Returns false if the ring is
+// full.
+bool interCore_pushRequest(const interCore_event_t *request) {
+    return queueSpsc_push(&requestRing, request);
+}
+
+// Consumer side of the request ring (core 1). Returns false if the ring is
+// empty.
+bool interCore_popRequest(interCore_event_t *request) {
+    return queueSpsc_pop(&requestRing, request);
+}
+
+// Returns the number of samples dropped because the sample ring was full. The
+// ISR never retries a refused sample, so every refused push is a drop.
+uint32_t interCore_getDroppedSampleCount() {
+    return queueSpsc_refusedCount(&sampleRing);
+}
+
+/******************************************************
+******************** Test Routines ********************
+******************************************************/
+
+#define INTERCORE_TEST_SAMPLE_COUNT 1000000 // 10 seconds of 100 kHz samples
+#define INTERCORE_TEST_SNAPSHOT_PERIOD 1000 // Samples per power snapshot
+#define INTERCORE_TEST_BLOCK_SIZE 64
+#define INTERCORE_TEST_ADC_MASK 0xFFF
+#define INTERCORE_TEST_HALF_OF_MAX_ADC_VALUE 2047.5
+
+static volatile uint32_t testOrderErrorCount;
+static volatile bool testCore1Done;
+
+// Runs on core 1 during the test. Drains the sample ring through the filters
+// and sends a power snapshot every INTERCORE_TEST_SNAPSHOT_PERIOD samples.
+static void interCore_testCore1Entry(void) {
+    interCore_sample_t samples[INTERCORE_TEST_BLOCK_SIZE];
+    uint32_t expected = 0;
+    uint32_t received = 0;
+    while (received < INTERCORE_TEST_SAMPLE_COUNT) {
+        uint32_t count = interCore_popSamples(samples, INTERCORE_TEST_BLOCK_SIZE);
+        for (uint32_t i = 0; i < count; i++) {
+            // The producer sends a ramp, so every sample is predictable
+            if (samples[i] != (expected & INTERCORE_TEST_ADC_MASK)) testOrderErrorCount++;
+            expected = samples[i] + 1;
+            filter_addNewInput((double)samples[i] / INTERCORE_TEST_HALF_OF_MAX_ADC_VALUE - 1.0);
+            received++;
+            // Run the decimated part of the pipeline
+            if (received % FILTER_FIR_DECIMATION_FACTOR == 0) {
+                filter_firFilter();
+                for (uint16_t filterNumber = 0; filterNumber < FILTER_FREQUENCY_COUNT; filterNumber++) {
+                    filter_iirFilter(filterNumber);
+                    filter_computePower(filterNumber, false, false);
+                }
+            }
+            // Send a power snapshot back to core 0
+            if (received % INTERCORE_TEST_SNAPSHOT_PERIOD == 0) {
+                interCore_event_t event;
+                event.type = interCore_powerEvent_e;
+                event.sequence = 0;
+                event.frequencyNumber = 0;
+                event.threshold = 0.0;
+                filter_getCurrentPowerValues(event.powerValues);
+                while (!interCore_pushEvent(&event));
+            }
+        }
+    }
+    testCore1Done = true;
+}
+
+// Pushes a ramp of samples through the sample ring to core 1, which runs the
+// filters and sends back power snapshots. Checks ordering and prints
+// throughput. Works on the board and on a host.
+void interCore_runTest() {
+    printf("STARTING: interCore_runTest()\n");
+    filter_init();
+    interCore_init();
+    testOrderErrorCount = 0;
+    testCore1Done = false;
+
+#ifdef ZYBO_BOARD
+    intervalTimer_init(INTERVAL_TIMER_TIMER_1);
+    intervalTimer_start(INTERVAL_TIMER_TIMER_1);
+#else
+    struct timespec startTime, endTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+#endif
+
+    interCore_startCore1(interCore_testCore1Entry);
+
+    // Core 0 produces samples as fast as the ring allows and drains events
+    uint32_t snapshotCount = 0;
+    interCore_event_t event;
+    for (uint32_t i = 0; i < INTERCORE_TEST_SAMPLE_COUNT; i++) {
+        while (!interCore_pushSample(i & INTERCORE_TEST_ADC_MASK)) {
+            if (interCore_popEvent(&event)) snapshotCount++;
+        }
+        if (interCore_popEvent(&event)) snapshotCount++;
+    }
+    while (!testCore1Done) {
+        if (interCore_popEvent(&event)) snapshotCount++;
+    }
+    while (interCore_popEvent(&event)) snapshotCount++;
+
+#ifdef ZYBO_BOARD
+    intervalTimer_stop(INTERVAL_TIMER_TIMER_1);
+    double seconds = intervalTimer_getTotalDurationInSeconds(INTERVAL_TIMER_TIMER_1);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    double seconds = (endTime.tv_sec - startTime.tv_sec) +
+                     (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+#endif
+
+    printf("samples: %d, order errors: %d, ring-full retries: %d\n", INTERCORE_TEST_SAMPLE_COUNT,
+           testOrderErrorCount, interCore_getDroppedSampleCount());
+    printf("power snapshots: %d (expected %d)\n", snapshotCount,
+           INTERCORE_TEST_SAMPLE_COUNT / INTERCORE_TEST_SNAPSHOT_PERIOD);
+    printf("elapsed: %.3f s, %.0f samples per second\n", seconds,
+           INTERCORE_TEST_SAMPLE_COUNT / seconds);
+    printf("TERMINATING: interCore_runTest()\n");
+}
+
+#ifdef INTERCORE_HOST_MAIN
+// Stand-alone host benchmark, see interCore.h.
+int main() {
+    interCore_runTest();
+    return 0;
+}
+#endif
@@ -0,0 +1,97 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef INTERCORE_H_
+#define INTERCORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h"
+
+// Asymmetric multiprocessing (AMP) support for the two Cortex-A9 cores.
+// Core 0 keeps the ISR, game, display and sound. Core 1 drains the ADC samples
+// and runs the filter and detector pipeline (see detector_core1Main()).
+// The cores talk through single-producer/single-consumer (SPSC) rings, each a
+// queueSpsc_t (see queueSpsc.h):
+// 1. samples: ISR on core 0 -> detector on core 1.
+// 2. events (hits and power snapshots): core 1 -> core 0.
+// 3. requests (events such as a flush): main loop on core 0 -> core 1.
+// On the ZYBO board, core 1 is released through the boot ROM wait loop (SEV).
+// Without ZYBO_BOARD, core 1 is modeled with a pthread so the partitioning can
+// be tested and benchmarked on a Linux host:
+//   gcc -DINTERCORE_HOST_MAIN -I. interCore.c queueSpsc.c filter.c queue.c -lpthread
+
+// Set to true to run the detector pipeline on core 1.
+#define INTERCORE_AMP_MODE false
+
+// Ring capacities, in elements. Must be powers of two.
+#define INTERCORE_SAMPLE_RING_SIZE 4096
+#define INTERCORE_EVENT_RING_SIZE 64
+#define INTERCORE_REQUEST_RING_SIZE 8
+
+// Kinds of messages sent between the cores.
+typedef enum {
+  interCore_hitEvent_e,   // A hit was detected on frequencyNumber.
+  interCore_powerEvent_e, // powerValues contains a snapshot of the band powers.
+  interCore_flushEvent_e  // Request (core 0 -> core 1): drop the pending
+                          // samples and start the filters and detector over.
+} interCore_eventType_t;
+
+// Message sent between the cores. Requests only use type and sequence.
+typedef struct {
+  interCore_eventType_t type;
+  uint32_t sequence; // Flushes requested so far; core 1 echoes it in events.
+  uint16_t frequencyNumber;
+  uint16_t consecutiveDecisions; // Streak of the hit band when it was decided.
+  double threshold; // Hit threshold the hit was decided on.
+  uint64_t sampleIndex; // Samples core 1 had received when it decided the hit.
+  double powerValues[FILTER_FREQUENCY_COUNT];
+} interCore_event_t;
+
+// Type of the raw ADC samples passed to core 1.
+typedef uint16_t interCore_sample_t;
+
+// Reset all rings to empty. Call on core 0 before interCore_startCore1().
+void interCore_init();
+
+// Start core 1 running entry(). Core 1 must never return on the board.
+void interCore_startCore1(void (*entry)(void));
+
+// Producer side of the sample ring (core 0 ISR). Returns false and counts a
+// dropped sample if the ring is full.
+bool interCore_pushSample(interCore_sample_t sample);
+
+// Consumer side of the sample ring (core 1). Copies up to max samples into dst
+// and returns the number copied.
+uint32_t interCore_popSamples(interCore_sample_t dst[], uint32_t max);
+
+// Producer side of the event ring (core 1). Returns false if the ring is full.
+bool interCore_pushEvent(const interCore_event_t *event);
+
+// Consumer side of the event ring (core 0). Returns false if the ring is empty.
+bool interCore_popEvent(interCore_event_t *event);
+
+// Producer side of the request ring (core 0 main loop, not the ISR). Returns
+// false if the ring is full.
+bool interCore_pushRequest(const interCore_event_t *request);
+
+// Consumer side of the request ring (core 1). Returns false if the ring is
+// empty.
+bool interCore_popRequest(interCore_event_t *request);
+
+// Returns the number of samples dropped because the sample ring was full.
+uint32_t interCore_getDroppedSampleCount();
+
+// Pushes a ramp of samples through the sample ring to core 1, which runs the
+// filters and sends back power snapshots. Checks ordering and prints
+// throughput. Works on the board and on a host.
+void interCore_runTest();
+
+#endif /* INTERCORE_H_ */
@@ -12,142 +12,29 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdint.h>
 #include "intervalTimer.h"
 #include "invincibilityTimer.h"
-
-#define DEBUG_INVINCIBILITY_TIMER false  // If true, debug messages enabled
+#include "timerService.h"
 
 // The invincibility Timer is active for 1/2 second once it is started.
 // It is used to lock-out the detector once a hit has been detected.
 // This ensures that only one hit is detected per 1/2-second interval.
 
-#define INVINCIBILITY_TIMER_EXPIRE_VALUE 500000 // Defined in terms of 100 kHz ticks.
+#define INVINCIBILITY_TIMER_DURATION_MS 5000
 #define INVINCIBILITY_TIMER_FUNCTIONAL_DELAY 1    // Imitate a pause to slow down the test loop
 
-// All printed messages for states are provided here.
-#define INIT_ST_MSG "init state\n"
-#define ACTIVE_ST_MSG "active state\n"
-#define INACTIVE_ST_MSG "inactive state\n"
-#define INVINCIBILITY_TIMER_UNKNOWN_ST_MSG "ERROR: Unknown state in Invincibility Timer\n"
-
 // Global variables
-static uint32_t tickCount;  // Tick counter
-static bool active;     // Timer is active
-static bool startTimer;     // Start the invincibility timer
-
-// State machine states
-enum invincibilityTimer_st_t {
-    INIT_ST,
-    INACTIVE_ST,
-    ACTIVE_ST
-};
-static enum invincibilityTimer_st_t currentState;
-
-// This is a debug state print routine. It will print the names of the states each
-// time tick() is called. It only prints states if they are different than the
-// previous state.
-static void debugStatePrint() {
-  static enum invincibilityTimer_st_t previousState;
-  static bool firstPass = true;
-  // Only print the message if:
-  // 1. This the first pass and the value for previousState is unknown.
-  // 2. previousState != currentState - this prevents reprinting the same state name over and over.
-  if (previousState != currentState || firstPass) {
-    firstPass = false;                // previousState will be defined, firstPass is false.
-    previousState = currentState;     // keep track of the last state that you were in.
-    switch(currentState) {            // This prints messages based upon the state that you were in.
-        case INIT_ST:
-            printf(INIT_ST_MSG);
-            break;
-        case ACTIVE_ST:
-            printf(ACTIVE_ST_MSG);
-            break;
-        case INACTIVE_ST:
-            printf(INACTIVE_ST_MSG);
-            break;
-        default:
-            // Error message here
-            printf(INVINCIBILITY_TIMER_UNKNOWN_ST_MSG);
-            break;
-     }
-  }
-}
-
+static timerService_timer_t timer;
 
 // Perform any necessary inits for the invincibility timer.
 void invincibilityTimer_init() {
-    currentState = INIT_ST;
-
-    // Default integer values
-    tickCount = 0;
-    // Default boolean values
-    active = false;
-};
-
-// Standard tick function.
-void invincibilityTimer_tick() {
-    
-    // Optional debug messages
-    if (DEBUG_INVINCIBILITY_TIMER) debugStatePrint();
-
-     // Perform state update
-    switch(currentState) {
-
-        case INIT_ST:
-            // Immediately transition to inactive state
-            currentState = INACTIVE_ST;
-            // Default boolean values
-            active = false;
-            break;
-
-        case INACTIVE_ST:
-            // If timer is to be started, transition to active state
-            if (startTimer) {
-                currentState = ACTIVE_ST;
-                // Reset tickCount to 0 and set active to true
-                tickCount = 0;
-                active = true;
-            }
-            break;
-
-        case ACTIVE_ST:
-            // If invincibility timer is over, return to inactive state
-            if (tickCount > INVINCIBILITY_TIMER_EXPIRE_VALUE) {
-                currentState = INACTIVE_ST;
-                //Reset tickCount to 0 and set active to false
-                tickCount = 0;
-                active = false;
-                startTimer = false;
-            }
-            break;
-
-        default:
-            // Error message here
-            printf(INVINCIBILITY_TIMER_UNKNOWN_ST_MSG);
-            break;
-    }
-
-    // Perform state actions
-    switch(currentState) {
-        case INIT_ST:
-            break;
-        case INACTIVE_ST:
-            break;
-        case ACTIVE_ST:
-            // Increment tick counter
-            tickCount++;
-            break;
-        default:
-            // Error message here
-            printf(INVINCIBILITY_TIMER_UNKNOWN_ST_MSG);
-            break;
-    }
+    timerService_initTimer(&timer, NULL);
 };
 
 // Calling this starts the timer.
 void invincibilityTimer_start() {
-    startTimer = true;
+    timerService_start(&timer, INVINCIBILITY_TIMER_DURATION_MS);
 };
 
 // Returns true if the timer is running.
 bool invincibilityTimer_running() {
-    return ((currentState == ACTIVE_ST) || active || startTimer);
+    return timerService_running(&timer);
 };
@@ -10,43 +10,189 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "hitLedTimer.h"
 #include "lockoutTimer.h"
 #include "invincibilityTimer.h"
+#include "timerService.h"
 #include "transmitter.h"
 #include "trigger.h"
 #include "interrupts.h"
 #include "buffer.h"
+#include "interCore.h"
 #include "sound.h"
 #include "game.h"
+#include "adcJitter.h"
 #include "isr.h"
+#include "isrProfiler.h"
 #include <stdio.h>
 
 // The interrupt service routine (ISR) is implemented here.
 // Add function calls for state machine tick functions and
 // other interrupt related modules.
+// ADC capture and transmitter_tick() (TRANSMITTER_BACKEND_TICK only) run on
+// every interrupt. The other tick functions only need millisecond resolution;
+// they are registered with a period and a phase and run only on the interrupts
+// where they are due.
+// isr_function() is split in two: the top half (ADC and transmitter) runs in
+// the timer interrupt so the sample is taken at a fixed point; the registered
+// tick functions (bottom half) run from the main loop, see isr_runBottomHalf().
+
+// Phases of the tasks registered in isr_init(), in timer interrupts. The 1 ms
+// tasks are spread over the millisecond and the sound task is placed so it
+// never lands on the same interrupt as one of them.
+#define ISR_TIMER_SERVICE_PHASE 0
+#define ISR_TRIGGER_PHASE 50
+#define ISR_SOUND_PHASE 2
+
+// A registered tick function.
+typedef struct {
+    isr_task_t tick;
+    uint32_t period;    // Timer interrupts between calls
+    uint32_t countdown; // Timer interrupts until the next call
+    int16_t profilerSlot; // Only used if ISR_PROFILER_ENABLED
+} isr_taskEntry_t;
+
+static isr_taskEntry_t tasks[ISR_MAX_TASK_COUNT];
+static uint16_t taskCount;
+
+// Profiler slots of the top half, only used if ISR_PROFILER_ENABLED.
+static int16_t adcProfilerSlot;
+static int16_t transmitterProfilerSlot;
+
+// Timer interrupts seen by the top half and handled by the bottom half.
+// topHalfTicks is only written by the top half. bottomHalfTicks is written by
+// whoever runs the bottom half; bottomHalfBusy keeps the timer interrupt from
+// running it while the main loop is, so the main loop can be preempted safely.
+static volatile uint32_t topHalfTicks;
+static volatile uint32_t bottomHalfTicks;
+static volatile bool bottomHalfBusy;
+static uint32_t bottomHalfMaxBacklog;
+static uint32_t bottomHalfIsrRunCount;
+
+// Registers tick to be called every periodTicks timer interrupts, the first
+// time phaseTicks interrupts after registration.
+bool isr_registerTask(isr_task_t tick, uint32_t periodTicks, uint32_t phaseTicks,
+                      const char *name) {
+    if (taskCount == ISR_MAX_TASK_COUNT || periodTicks == 0) {
+        printf("ERROR in isr_registerTask(): cannot register task %d.\n", taskCount);
+        return false;
+    }
+    tasks[taskCount].tick = tick;
+    tasks[taskCount].period = periodTicks;
+    // Counted down before the check, so +1 runs it on interrupt phaseTicks.
+    tasks[taskCount].countdown = (phaseTicks % periodTicks) + 1;
+    tasks[taskCount].profilerSlot =
+        ISR_PROFILER_ENABLED ? isrProfiler_addSlot(name) : ISR_PROFILER_NO_SLOT;
+    taskCount++;
+    return true;
+}
+
+// Calls the registered tick functions that are due on one timer interrupt.
+static void isr_runTasks() {
+    for (uint16_t i = 0; i < taskCount; i++) {
+        if (--tasks[i].countdown == 0) {
+            tasks[i].countdown = tasks[i].period;
+            if (ISR_PROFILER_ENABLED) {
+                isrProfiler_sample_t start;
+                isrProfiler_start(&start);
+                tasks[i].tick();
+                isrProfiler_stop(tasks[i].profilerSlot, &start);
+            } else {
+                tasks[i].tick();
+            }
+        }
+    }
+}
+
+// Bottom half: catches up on every timer interrupt since the last call, so
+// no tick is lost if it was delayed by more than one interrupt.
+static void __attribute__((noinline)) isr_bottomHalf() {
+    uint32_t backlog = topHalfTicks - bottomHalfTicks;
+    if (backlog > bottomHalfMaxBacklog) bottomHalfMaxBacklog = backlog;
+    while (bottomHalfTicks != topHalfTicks) {
+        bottomHalfTicks++;
+        isr_runTasks();
+    }
+}
+
+// Runs the bottom half from the main loop. The timer interrupt sees
+// bottomHalfBusy and leaves the catch-up to this call.
+void isr_runBottomHalf() {
+    bottomHalfBusy = true;
+    isr_bottomHalf();
+    bottomHalfBusy = false;
+}
 
 // Perform initialization for interrupt and timing related modules.
 void isr_init() {
 
-    // Call state machine initializations
+    // Call state machine initializations, the timer service before the timers
+    timerService_init();
     hitLedTimer_init();
     lockoutTimer_init();
-    invincibilityTimer_tick();
+    invincibilityTimer_init();
     transmitter_init();
     trigger_init();
     buffer_init();
     sound_init();
+
+    adcJitter_init();
+
+    // Profiler slots for the top half first, the tasks add theirs below
+    if (ISR_PROFILER_ENABLED) {
+        isrProfiler_init();
+        adcProfilerSlot = isrProfiler_addSlot("adc");
+        transmitterProfilerSlot = isrProfiler_addSlot("transmitter");
+    }
+
+    // Register the tick functions that do not need the full 100 kHz rate
+    taskCount = 0;
+    topHalfTicks = 0;
+    bottomHalfTicks = 0;
+    bottomHalfBusy = false;
+    bottomHalfMaxBacklog = 0;
+    bottomHalfIsrRunCount = 0;
+    // (the hit LED, lockout and invincibility timers all run on the timer service)
+    isr_registerTask(timerService_tick, TIMER_SERVICE_TICK_PERIOD, ISR_TIMER_SERVICE_PHASE,
+                     "timerService");
+    isr_registerTask(trigger_tick, TRIGGER_TICK_PERIOD, ISR_TRIGGER_PHASE, "trigger");
+    isr_registerTask(sound_tick, SOUND_TICK_PERIOD, ISR_SOUND_PHASE, "sound");
 };
 
 // This function is invoked by the timer interrupt at 100 kHz.
 void isr_function() {
 
-    // Call tick functions
-    hitLedTimer_tick();
-    lockoutTimer_tick();
-    invincibilityTimer_tick();
-    transmitter_tick();
-    trigger_tick();
-    sound_tick();
-    // Get adc data
-    buffer_pushover(interrupts_getAdcData());
+    // Get adc data first so it is sampled at a fixed point in every interrupt,
+    // in AMP mode it goes straight to core 1
+    // The private timer value at the ADC read gives the sampling jitter
+    adcJitter_latch(interrupts_getPrivateTimerCounterValue());
+    isrProfiler_sample_t start;
+    if (ISR_PROFILER_ENABLED) isrProfiler_start(&start);
+    if (INTERCORE_AMP_MODE) interCore_pushSample(interrupts_getAdcData());
+    else buffer_pushover(interrupts_getAdcData());
+    if (ISR_PROFILER_ENABLED) isrProfiler_stop(adcProfilerSlot, &start);
+
+    // Transmitter edges need every tick, unless a timer generates the carrier
+    if (TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_TICK) {
+        if (ISR_PROFILER_ENABLED) isrProfiler_start(&start);
+        transmitter_tick();
+        if (ISR_PROFILER_ENABLED) isrProfiler_stop(transmitterProfilerSlot, &start);
+    }
+
+    // Hand the registered tick functions to the bottom half, unless the main
+    // loop has stopped polling it
+    topHalfTicks++;
+    if (!bottomHalfBusy &&
+        topHalfTicks - bottomHalfTicks >= ISR_BOTTOM_HALF_MAX_BACKLOG) {
+        bottomHalfIsrRunCount++;
+        isr_bottomHalf();
+    }
 };
 
+// Returns the largest number of timer interrupts the bottom half has been
+// behind the top half, since isr_init().
+uint32_t isr_getBottomHalfMaxBacklog() {
+    return bottomHalfMaxBacklog;
+}
+
+// Returns how many times isr_function() ran the bottom half, since isr_init().
+uint32_t isr_getBottomHalfIsrRunCount() {
+    return bottomHalfIsrRunCount;
+}
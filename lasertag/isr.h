@@ -14,10 +14,52 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // Add function calls for state machine tick functions and
 // other interrupt related modules.
 
+#include <stdbool.h>
+#include <stdint.h>
+
+// Timer interrupts per millisecond (the ISR runs at 100 kHz).
+#define ISR_TICKS_PER_MILLISECOND 100
+
+// isr_function() (the top half) only samples the ADC and runs
+// transmitter_tick(). The registered tick functions (the bottom half) are run
+// by the main loop through isr_runBottomHalf(). If the main loop falls this
+// many timer interrupts behind (e.g. it is waiting in utils_msDelay() or
+// sound_waitForSoundToFinish()), isr_function() runs the bottom half itself.
+#define ISR_BOTTOM_HALF_MAX_BACKLOG ISR_TICKS_PER_MILLISECOND
+
+// Maximum number of tick functions that isr_registerTask() accepts.
+#define ISR_MAX_TASK_COUNT 8
+
+// A state machine tick function.
+typedef void (*isr_task_t)();
+
 // Perform initialization for interrupt and timing related modules.
+// Registers the tick functions of those modules with isr_registerTask().
 void isr_init();
 
+// Runs the registered tick functions for every timer interrupt since the last
+// call (the bottom half). Call it on every main-loop pass, with interrupts
+// enabled; the timer interrupt keeps sampling while it runs.
+void isr_runBottomHalf();
+
+// Registers tick so that isr_function() calls it every periodTicks timer
+// interrupts, the first time phaseTicks interrupts after registration
+// (phaseTicks < periodTicks). Give tasks with the same period different phases
+// so their work is spread over different interrupts. name labels the task in
+// the ISR profile (see isrProfiler.h). Returns false if ISR_MAX_TASK_COUNT
+// tasks are already registered or periodTicks is 0.
+bool isr_registerTask(isr_task_t tick, uint32_t periodTicks, uint32_t phaseTicks,
+                      const char *name);
+
 // This function is invoked by the timer interrupt at 100 kHz.
 void isr_function();
 
+// Returns the largest number of timer interrupts the bottom half has been
+// behind the top half, since isr_init(). 1 means it always kept up.
+uint32_t isr_getBottomHalfMaxBacklog();
+
+// Returns how many times isr_function() had to run the bottom half because the
+// main loop was ISR_BOTTOM_HALF_MAX_BACKLOG interrupts behind, since isr_init().
+uint32_t isr_getBottomHalfIsrRunCount();
+
 #endif /* ISR_H_ */
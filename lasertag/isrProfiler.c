@@ -0,0 +1,232 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "isrProfiler.h"
+
+#ifdef ZYBO_BOARD
+#include "xpm_counter.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#define ISR_PROFILER_UNIT "cycles"
+#else
+#include <time.h>
+#define ISR_PROFILER_UNIT "ns"
+#endif
+
+// PMU setup: PMCR enable (E), reset event counters (P), reset cycle counter
+// (C). Event counter 0 counts data cache refills, 1 instruction cache refills.
+#define ISR_PROFILER_PMCR_ENABLE_AND_RESET 0x7
+#define ISR_PROFILER_DCACHE_COUNTER 0
+#define ISR_PROFILER_ICACHE_COUNTER 1
+#define ISR_PROFILER_CYCLE_COUNTER_BIT 0x80000000
+
+static isrProfiler_slot_t slots[ISR_PROFILER_MAX_SLOTS];
+static uint16_t slotCount;
+
+///////////////////////
+/// HELPER FUNCTIONS //
+///////////////////////
+
+#ifdef ZYBO_BOARD
+// Reads PMU event counter number counter. Selecting and reading are two
+// steps, so IRQs are masked in case the timer interrupt profiles in between.
+static inline uint32_t isrProfiler_readEventCounter(uint32_t counter) {
+    uint32_t cpsr = mfcpsr();
+    mtcpsr(cpsr | XREG_CPSR_IRQ_ENABLE);
+    mtcp(XREG_CP15_EVENT_CNTR_SEL, counter);
+    isb();
+    uint32_t value = mfcp(XREG_CP15_PERF_MONITOR_COUNT);
+    mtcpsr(cpsr);
+    return value;
+}
+
+// Sets event counter number counter to count event.
+static void isrProfiler_setEvent(uint32_t counter, uint32_t event) {
+    mtcp(XREG_CP15_EVENT_CNTR_SEL, counter);
+    isb();
+    mtcp(XREG_CP15_EVENT_TYPE_SEL, event);
+}
+#endif
+
+// Reads the current counter values.
+static inline void isrProfiler_read(isrProfiler_sample_t *sample) {
+#ifdef ZYBO_BOARD
+    sample->cycles = mfcp(XREG_CP15_PERF_CYCLE_COUNTER);
+    sample->dcacheMisses = isrProfiler_readEventCounter(ISR_PROFILER_DCACHE_COUNTER);
+    sample->icacheMisses = isrProfiler_readEventCounter(ISR_PROFILER_ICACHE_COUNTER);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    sample->cycles = (uint32_t)(now.tv_sec * 1000000000ull + now.tv_nsec);
+    sample->dcacheMisses = 0;
+    sample->icacheMisses = 0;
+#endif
+}
+
+// Returns the histogram bucket for a call that took cycles.
+static inline uint16_t isrProfiler_bucket(uint32_t cycles) {
+    uint16_t bucket = 31 - __builtin_clz(cycles | 1);
+    return bucket < ISR_PROFILER_HISTOGRAM_BUCKETS ? bucket
+                                                   : ISR_PROFILER_HISTOGRAM_BUCKETS - 1;
+}
+
+/////////////////////
+/// MAIN FUNCTIONS //
+/////////////////////
+
+// Clears all slots and starts the counters.
+void isrProfiler_init() {
+    memset(slots, 0, sizeof(slots));
+    slotCount = 0;
+#ifdef ZYBO_BOARD
+    isrProfiler_setEvent(ISR_PROFILER_DCACHE_COUNTER, XPM_EVENT_DATA_CACHEREFILL);
+    isrProfiler_setEvent(ISR_PROFILER_ICACHE_COUNTER, XPM_EVENT_INSRFETCH_CACHEREFILL);
+    mtcp(XREG_CP15_COUNT_ENABLE_SET, ISR_PROFILER_CYCLE_COUNTER_BIT |
+                                         (1 << ISR_PROFILER_DCACHE_COUNTER) |
+                                         (1 << ISR_PROFILER_ICACHE_COUNTER));
+    mtcp(XREG_CP15_PERF_MONITOR_CTRL, ISR_PROFILER_PMCR_ENABLE_AND_RESET);
+    isb();
+#endif
+}
+
+// Adds a slot for the function called name and returns its number.
+int16_t isrProfiler_addSlot(const char *name) {
+    if (slotCount == ISR_PROFILER_MAX_SLOTS) {
+        printf("ERROR in isrProfiler_addSlot(): no slot left for %s.\n", name);
+        return ISR_PROFILER_NO_SLOT;
+    }
+    slots[slotCount].name = name;
+    slots[slotCount].minCycles = UINT32_MAX;
+    return slotCount++;
+}
+
+// Reads the counters into start.
+void isrProfiler_start(isrProfiler_sample_t *start) {
+    isrProfiler_read(start);
+}
+
+// Reads the counters again and adds the difference to start to slot.
+void isrProfiler_stop(int16_t slot, const isrProfiler_sample_t *start) {
+    isrProfiler_sample_t end;
+    isrProfiler_read(&end);
+    if (slot < 0 || slot >= slotCount) return;
+    isrProfiler_slot_t *s = &slots[slot];
+    // Unsigned differences stay correct when a counter wraps
+    uint32_t cycles = end.cycles - start->cycles;
+    uint32_t dcacheMisses = end.dcacheMisses - start->dcacheMisses;
+    s->count++;
+    if (cycles < s->minCycles) s->minCycles = cycles;
+    if (cycles > s->maxCycles) s->maxCycles = cycles;
+    s->totalCycles += cycles;
+    s->histogram[isrProfiler_bucket(cycles)]++;
+    s->totalDcacheMisses += dcacheMisses;
+    s->totalIcacheMisses += end.icacheMisses - start->icacheMisses;
+    if (dcacheMisses > s->maxDcacheMisses) s->maxDcacheMisses = dcacheMisses;
+}
+
+// Returns the statistics of slot, NULL if there is no such slot.
+const isrProfiler_slot_t *isrProfiler_getSlot(int16_t slot) {
+    if (slot < 0 || slot >= slotCount) return NULL;
+    return &slots[slot];
+}
+
+// Prints the statistics of all slots to the console.
+void isrProfiler_print() {
+    printf("ISR profile (%s per call):\n", ISR_PROFILER_UNIT);
+    printf("%-16s %10s %8s %10s %8s %10s %10s %8s\n", "function", "calls", "min", "mean",
+           "max", "D$/call", "I$/call", "max D$");
+    for (uint16_t i = 0; i < slotCount; i++) {
+        isrProfiler_slot_t *s = &slots[i];
+        if (s->count == 0) {
+            printf("%-16s %10d\n", s->name, 0);
+            continue;
+        }
+        printf("%-16s %10lu %8lu %10.1f %8lu %10.2f %10.2f %8lu\n", s->name,
+               (unsigned long)s->count, (unsigned long)s->minCycles,
+               (double)s->totalCycles / s->count, (unsigned long)s->maxCycles,
+               (double)s->totalDcacheMisses / s->count,
+               (double)s->totalIcacheMisses / s->count, (unsigned long)s->maxDcacheMisses);
+    }
+    // Histograms, empty buckets left out
+    for (uint16_t i = 0; i < slotCount; i++) {
+        printf("%s:", slots[i].name);
+        for (uint16_t b = 0; b < ISR_PROFILER_HISTOGRAM_BUCKETS; b++) {
+            if (slots[i].histogram[b])
+                printf(" %s%lu:%lu", b == ISR_PROFILER_HISTOGRAM_BUCKETS - 1 ? ">=" : "",
+                       1ul << b, (unsigned long)slots[i].histogram[b]);
+        }
+        printf("\n");
+    }
+}
+
+/******************************************************
+******************** Test Routines ********************
+******************************************************/
+
+#define ISR_PROFILER_TEST_LOOP_COUNT 3
+#define ISR_PROFILER_TEST_CALL_COUNT 100
+#define ISR_PROFILER_TEST_SHORT_LOOP 100
+#define ISR_PROFILER_TEST_LOOP_FACTOR 10
+
+// Busy loop of iterations iterations.
+static void isrProfiler_testLoop(uint32_t iterations) {
+    for (volatile uint32_t i = 0; i < iterations; i++);
+}
+
+// Profiles loops of increasing length and checks that the statistics are
+// consistent.
+void isrProfiler_runTest() {
+    printf("STARTING: isrProfiler_runTest()\n");
+    const char *names[ISR_PROFILER_TEST_LOOP_COUNT] = {"loop x1", "loop x10", "loop x100"};
+    int16_t testSlots[ISR_PROFILER_TEST_LOOP_COUNT];
+    isrProfiler_init();
+    for (uint16_t i = 0; i < ISR_PROFILER_TEST_LOOP_COUNT; i++)
+        testSlots[i] = isrProfiler_addSlot(names[i]);
+
+    for (uint16_t call = 0; call < ISR_PROFILER_TEST_CALL_COUNT; call++) {
+        uint32_t iterations = ISR_PROFILER_TEST_SHORT_LOOP;
+        for (uint16_t i = 0; i < ISR_PROFILER_TEST_LOOP_COUNT; i++) {
+            isrProfiler_sample_t start;
+            isrProfiler_start(&start);
+            isrProfiler_testLoop(iterations);
+            isrProfiler_stop(testSlots[i], &start);
+            iterations *= ISR_PROFILER_TEST_LOOP_FACTOR;
+        }
+    }
+    isrProfiler_print();
+
+    // Every slot saw every call, min <= mean <= max, and longer loops have a
+    // longer mean
+    bool passed = true;
+    double previousMean = 0;
+    for (uint16_t i = 0; i < ISR_PROFILER_TEST_LOOP_COUNT; i++) {
+        const isrProfiler_slot_t *s = isrProfiler_getSlot(testSlots[i]);
+        double mean = (double)s->totalCycles / s->count;
+        uint32_t histogramCount = 0;
+        for (uint16_t b = 0; b < ISR_PROFILER_HISTOGRAM_BUCKETS; b++)
+            histogramCount += s->histogram[b];
+        if (s->count != ISR_PROFILER_TEST_CALL_COUNT ||
+            histogramCount != ISR_PROFILER_TEST_CALL_COUNT || mean < s->minCycles ||
+            mean > s->maxCycles || mean <= previousMean)
+            passed = false;
+        previousMean = mean;
+    }
+    printf("%s\n", passed ? "isrProfiler test passed." : "isrProfiler test FAILED.");
+    printf("TERMINATING: isrProfiler_runTest()\n");
+}
+
+#ifdef ISRPROFILER_HOST_MAIN
+// Stand-alone host test, see isrProfiler.h.
+int main() {
+    isrProfiler_runTest();
+    return 0;
+}
+#endif
@@ -0,0 +1,89 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef ISRPROFILER_H_
+#define ISRPROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-function execution time profiler for the ISR. Each profiled piece of
+// code (the ADC read, transmitter_tick(), every registered tick function) gets
+// a slot that records the min, max and mean time per call, a histogram with
+// power-of-two buckets, and the L1 data/instruction cache misses.
+// On the ZYBO board time is measured in CPU cycles with the Cortex-A9 PMU
+// cycle counter and the misses with two PMU event counters. On a host it
+// falls back to clock_gettime() in nanoseconds (no cache misses):
+//   gcc -DISRPROFILER_HOST_MAIN -I. isrProfiler.c
+// A call to a tick function that is preempted by the timer interrupt (see
+// isr_runBottomHalf()) also counts the time of the top half.
+
+// Set to true to profile isr_function(). The statistics are printed with the
+// run-time statistics at the end of a run.
+#ifndef ISR_PROFILER_ENABLED
+#define ISR_PROFILER_ENABLED false
+#endif
+
+// Maximum number of profiled functions.
+#define ISR_PROFILER_MAX_SLOTS 12
+
+// Histogram bucket k counts calls that took 2^k to 2^(k+1)-1 cycles (bucket 0
+// also counts 0). The last bucket also counts everything longer.
+#define ISR_PROFILER_HISTOGRAM_BUCKETS 20
+
+// Returned by isrProfiler_addSlot() when all slots are taken. Samples for it
+// are ignored.
+#define ISR_PROFILER_NO_SLOT -1
+
+// Counter values at the start of a measurement.
+typedef struct {
+    uint32_t cycles;
+    uint32_t dcacheMisses;
+    uint32_t icacheMisses;
+} isrProfiler_sample_t;
+
+// Statistics of one profiled function.
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t histogram[ISR_PROFILER_HISTOGRAM_BUCKETS];
+    uint64_t totalDcacheMisses;
+    uint64_t totalIcacheMisses;
+    uint32_t maxDcacheMisses; // Most data cache misses in a single call
+} isrProfiler_slot_t;
+
+// Clears all slots and starts the counters. Called by isr_init().
+void isrProfiler_init();
+
+// Adds a slot for the function called name and returns its number, or
+// ISR_PROFILER_NO_SLOT if ISR_PROFILER_MAX_SLOTS slots are already in use.
+// name must stay valid (use a string literal).
+int16_t isrProfiler_addSlot(const char *name);
+
+// Reads the counters into start. Call right before the profiled code.
+void isrProfiler_start(isrProfiler_sample_t *start);
+
+// Reads the counters again and adds the difference to start to slot. Call
+// right after the profiled code.
+void isrProfiler_stop(int16_t slot, const isrProfiler_sample_t *start);
+
+// Returns the statistics of slot, NULL if there is no such slot.
+const isrProfiler_slot_t *isrProfiler_getSlot(int16_t slot);
+
+// Prints the statistics of all slots to the console (UART).
+void isrProfiler_print();
+
+// Profiles loops of increasing length and checks that the statistics are
+// consistent. Runs without interrupts.
+void isrProfiler_runTest();
+
+#endif /* ISRPROFILER_H_ */
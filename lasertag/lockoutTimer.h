@@ -11,21 +11,27 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define LOCKOUTTIMER_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // Perform any necessary inits for the lockout timer.
 void lockoutTimer_init();
 
-// Standard tick function.
-void lockoutTimer_tick();
-
 // Calling this starts the timer.
 void lockoutTimer_start();
 
 // Returns true if the timer is running.
 bool lockoutTimer_running();
 
+// Calling this starts a lockout for a single frequency only. Used by the
+// detector in multi-hit mode so that each shooter is locked out separately
+// and a hit on one frequency does not hide a hit on another.
+void lockoutTimer_startFrequency(uint16_t frequencyNumber);
+
+// Returns true if the lockout for frequencyNumber is running.
+bool lockoutTimer_frequencyRunning(uint16_t frequencyNumber);
+
 // Test function assumes interrupts have been completely enabled and
-// lockoutTimer_tick() function is invoked by isr_function().
+// timerService_tick() function is invoked by isr_function().
 // Prints out pass/fail status and other info to console.
 // Returns true if passes, false otherwise.
 // This test uses the interval timer to determine correct delay for
@@ -22,6 +22,7 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <assert.h>
 #include <stdio.h>
 
+#include "adcJitter.h"
 #include "bufferTest.h"
 #include "buffer.h"
 #include "buttons.h"
@@ -31,16 +32,20 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "filterTest.h"
 #include "game.h"
 #include "hitLedTimer.h"
+#include "interCore.h"
 #include "interrupts.h"
 #include "isr.h"
+#include "isrProfiler.h"
 #include "leds.h"
 #include "lockoutTimer.h"
 #include "mio.h"
 #include "runningModes.h"
 #include "sound.h"
 #include "switches.h"
+#include "timerService.h"
 #include "transmitter.h"
 #include "trigger.h"
+#include "queueSpsc.h"
 #include "queueTest.h"
 
 int main() {
@@ -59,7 +64,16 @@ int main() {
   // transmitter_runTest(); // M3 T2
   // buffer_runTest(); // M3 T3
   // detector_runTest(); // M3 T3
+  // detector_runDecisionRateTest(); // M3 T3
   // sound_runTest(); // M5
+  // interCore_runTest(); // AMP
+  // queueSpsc_runTest(interCore_startCore1); // AMP
+  // isrProfiler_runTest();
+  // adcJitter_runTest();
+  // transmitter_runTestWaveform();
+#if TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK
+  // transmitter_runTestCarrier();
+#endif
 #endif
 
 #ifdef RUNNING_MODE_M3_T2
@@ -78,13 +92,25 @@ int main() {
   trigger_runTest();  // FUNCTIONAL
   // hitLedTimer_runTest(); // FUNCTIONAL
   // lockoutTimer_runTest(); // FUNCTIONAL
+  // timerService_runTest(); // FUNCTIONAL
 #endif
 
 #ifdef RUNNING_MODE_M3_T3
   // The program comes up in continuous mode by default.
-  // Hold BTN2 while the program starts to come up in shooter mode.
+  // Hold BTN2 while the program starts to come up in shooter mode, hold BTN0
+  // as well for multi-hit shooter mode.
+  // Hold BTN1 to first calibrate the hit threshold (no shooters present).
   // Interrupts are enabled in runningModes.
-  if (buttons_read() & BUTTONS_BTN2_MASK) {
+  int32_t startupButtons = buttons_read();
+  if (startupButtons & BUTTONS_BTN1_MASK) {
+    printf("Starting calibration mode\n");
+    runningModes_calibrate();
+  }
+  if ((startupButtons & BUTTONS_BTN2_MASK) &&
+      (startupButtons & BUTTONS_BTN0_MASK)) {
+    printf("Starting multi-hit shooter mode\n");
+    runningModes_shooterMultiHit();
+  } else if (startupButtons & BUTTONS_BTN2_MASK) {
     printf("Starting shooter mode\n");
     runningModes_shooter(); // Run shooter mode if BTN2 is depressed.
   } else {
@@ -0,0 +1,241 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queueSpsc.h"
+
+#ifdef QUEUESPSC_HOST_MAIN
+#include <pthread.h>
+#endif
+
+///////////////////////
+/// HELPER FUNCTIONS //
+///////////////////////
+
+// Address of the slot for a free-running index.
+static inline uint8_t *queueSpsc_slot(queueSpsc_t *q, queue_index_t index) {
+    return &q->data[(index & (q->size - 1)) * q->elementSize];
+}
+
+// Copies n elements from src into the slots starting at index, wrapping at the
+// end of the data array (at most two memcpy() segments).
+static void queueSpsc_copyIn(queueSpsc_t *q, queue_index_t index, const uint8_t *src,
+                             queue_size_t n) {
+    queue_size_t first = q->size - (index & (q->size - 1));
+    if (first > n) first = n;
+    memcpy(queueSpsc_slot(q, index), src, first * q->elementSize);
+    memcpy(q->data, src + first * q->elementSize, (n - first) * q->elementSize);
+}
+
+// Copies n elements starting at index into dst, wrapping at the end of the data
+// array (at most two memcpy() segments).
+static void queueSpsc_copyOut(queueSpsc_t *q, queue_index_t index, uint8_t *dst,
+                              queue_size_t n) {
+    queue_size_t first = q->size - (index & (q->size - 1));
+    if (first > n) first = n;
+    memcpy(dst, queueSpsc_slot(q, index), first * q->elementSize);
+    memcpy(dst + first * q->elementSize, q->data, (n - first) * q->elementSize);
+}
+
+// Producer: free slots, reloading indexOut (the consumer's cache line) only
+// when the cached copy says there are fewer than wanted.
+static queue_size_t queueSpsc_room(queueSpsc_t *q, queue_index_t indexIn, queue_size_t wanted) {
+    queue_size_t room = q->size - (indexIn - q->producerIndexOutCache);
+    if (room < wanted) {
+        q->producerIndexOutCache = atomic_load_explicit(&q->indexOut, memory_order_acquire);
+        room = q->size - (indexIn - q->producerIndexOutCache);
+    }
+    return room;
+}
+
+// Consumer: queued elements, reloading indexIn (the producer's cache line) only
+// when the cached copy says there are fewer than wanted.
+static queue_size_t queueSpsc_available(queueSpsc_t *q, queue_index_t indexOut,
+                                        queue_size_t wanted) {
+    queue_size_t available = q->consumerIndexInCache - indexOut;
+    if (available < wanted) {
+        q->consumerIndexInCache = atomic_load_explicit(&q->indexIn, memory_order_acquire);
+        available = q->consumerIndexInCache - indexOut;
+    }
+    return available;
+}
+
+/////////////////////
+/// MAIN FUNCTIONS //
+/////////////////////
+
+// Initializes an empty queue on caller-provided storage of size * elementSize
+// bytes. size must be a power of two, calls abort() otherwise.
+void queueSpsc_init(queueSpsc_t *q, void *storage, queue_size_t size, uint32_t elementSize,
+                    const char *name) {
+    if (size == 0 || (size & (size - 1)) != 0) abort();
+    q->data = storage;
+    q->size = size;
+    q->elementSize = elementSize;
+    strncpy(q->name, name, QUEUE_MAX_NAME_SIZE);
+    q->name[QUEUE_MAX_NAME_SIZE - 1] = '\0';
+    q->producerIndexOutCache = 0;
+    q->consumerIndexInCache = 0;
+    atomic_store_explicit(&q->refusedCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->indexOut, 0, memory_order_relaxed);
+    // Publish everything above to whichever context runs first.
+    atomic_store_explicit(&q->indexIn, 0, memory_order_release);
+}
+
+// Producer only. Returns false and counts a refused element if the queue is
+// full.
+bool queueSpsc_push(queueSpsc_t *q, const void *element) {
+    // Only this side writes indexIn, so a relaxed load is enough.
+    queue_index_t indexIn = atomic_load_explicit(&q->indexIn, memory_order_relaxed);
+    if (queueSpsc_room(q, indexIn, 1) == 0) {
+        atomic_fetch_add_explicit(&q->refusedCount, 1, memory_order_relaxed);
+        return false;
+    }
+    memcpy(queueSpsc_slot(q, indexIn), element, q->elementSize);
+    // The element is written before the consumer can see the new indexIn.
+    atomic_store_explicit(&q->indexIn, indexIn + 1, memory_order_release);
+    return true;
+}
+
+// Consumer only. Returns false if the queue is empty.
+bool queueSpsc_pop(queueSpsc_t *q, void *element) {
+    queue_index_t indexOut = atomic_load_explicit(&q->indexOut, memory_order_relaxed);
+    if (queueSpsc_available(q, indexOut, 1) == 0) return false;
+    memcpy(element, queueSpsc_slot(q, indexOut), q->elementSize);
+    // The element is read before the producer can reuse its slot.
+    atomic_store_explicit(&q->indexOut, indexOut + 1, memory_order_release);
+    return true;
+}
+
+// Producer only. Pushes up to n elements, counts the rest as refused.
+queue_size_t queueSpsc_pushBlock(queueSpsc_t *q, const void *src, queue_size_t n) {
+    queue_index_t indexIn = atomic_load_explicit(&q->indexIn, memory_order_relaxed);
+    queue_size_t room = queueSpsc_room(q, indexIn, n);
+    if (n > room) {
+        atomic_fetch_add_explicit(&q->refusedCount, n - room, memory_order_relaxed);
+        n = room;
+    }
+    if (n == 0) return 0;
+    queueSpsc_copyIn(q, indexIn, src, n);
+    atomic_store_explicit(&q->indexIn, indexIn + n, memory_order_release);
+    return n;
+}
+
+// Consumer only. Pops up to n elements into dst.
+queue_size_t queueSpsc_popBlock(queueSpsc_t *q, void *dst, queue_size_t n) {
+    queue_index_t indexOut = atomic_load_explicit(&q->indexOut, memory_order_relaxed);
+    queue_size_t available = queueSpsc_available(q, indexOut, n);
+    if (n > available) n = available;
+    if (n == 0) return 0;
+    queueSpsc_copyOut(q, indexOut, dst, n);
+    atomic_store_explicit(&q->indexOut, indexOut + n, memory_order_release);
+    return n;
+}
+
+// Returns the number of queued elements, possibly stale.
+queue_size_t queueSpsc_elementCount(queueSpsc_t *q) {
+    queue_index_t indexOut = atomic_load_explicit(&q->indexOut, memory_order_acquire);
+    return atomic_load_explicit(&q->indexIn, memory_order_acquire) - indexOut;
+}
+
+// Returns the number of elements refused because the queue was full.
+uint32_t queueSpsc_refusedCount(queueSpsc_t *q) {
+    return atomic_load_explicit(&q->refusedCount, memory_order_relaxed);
+}
+
+// Get the user-assigned name for the queue.
+const char *queueSpsc_name(queueSpsc_t *q) { return q->name; }
+
+/******************************************************
+******************** Test Routines ********************
+******************************************************/
+
+#define QUEUESPSC_TEST_QUEUE_SIZE 256
+#define QUEUESPSC_TEST_COUNT 1000000
+#define QUEUESPSC_TEST_BLOCK_SIZE 37 // Not a divisor of the size, so blocks wrap.
+
+static queueSpsc_t testQueue;
+static uint32_t testStorage[QUEUESPSC_TEST_QUEUE_SIZE];
+static volatile uint32_t testOrderErrorCount;
+static atomic_bool testConsumerDone;
+
+// Runs in the consumer context (core 1, or a thread on a host). Pops single elements and blocks in turn
+// and checks that the sequence 0, 1, 2, ... arrives without gaps.
+static void queueSpsc_testConsumer(void) {
+    uint32_t block[QUEUESPSC_TEST_BLOCK_SIZE];
+    uint32_t expected = 0;
+    while (expected < QUEUESPSC_TEST_COUNT) {
+        uint32_t value;
+        if (queueSpsc_pop(&testQueue, &value)) {
+            if (value != expected) testOrderErrorCount++;
+            expected = value + 1;
+        }
+        queue_size_t count = queueSpsc_popBlock(&testQueue, block, QUEUESPSC_TEST_BLOCK_SIZE);
+        for (queue_size_t i = 0; i < count; i++) {
+            if (block[i] != expected) testOrderErrorCount++;
+            expected = block[i] + 1;
+        }
+    }
+    atomic_store_explicit(&testConsumerDone, true, memory_order_release);
+}
+
+// Pushes a sequence through a queue to a consumer started with
+// startConsumer() and checks that it arrives complete and in order.
+void queueSpsc_runTest(void (*startConsumer)(void (*consumer)(void))) {
+    printf("STARTING: queueSpsc_runTest()\n");
+    queueSpsc_init(&testQueue, testStorage, QUEUESPSC_TEST_QUEUE_SIZE, sizeof(uint32_t),
+                   "spscTestQueue");
+    testOrderErrorCount = 0;
+    atomic_store_explicit(&testConsumerDone, false, memory_order_relaxed);
+    startConsumer(queueSpsc_testConsumer);
+
+    // Alternate single pushes and block pushes, retrying when the queue is full.
+    uint32_t next = 0;
+    uint32_t block[QUEUESPSC_TEST_BLOCK_SIZE];
+    while (next < QUEUESPSC_TEST_COUNT) {
+        if (queueSpsc_push(&testQueue, &next)) next++;
+        queue_size_t n = QUEUESPSC_TEST_COUNT - next;
+        if (n > QUEUESPSC_TEST_BLOCK_SIZE) n = QUEUESPSC_TEST_BLOCK_SIZE;
+        for (queue_size_t i = 0; i < n; i++) block[i] = next + i;
+        next += queueSpsc_pushBlock(&testQueue, block, n);
+    }
+    while (!atomic_load_explicit(&testConsumerDone, memory_order_acquire));
+
+    // The producer retries every refused element, so none is lost
+    printf("%s: %d values, order errors: %u, refused while full (all retried): %u\n",
+           queueSpsc_name(&testQueue), QUEUESPSC_TEST_COUNT, testOrderErrorCount,
+           queueSpsc_refusedCount(&testQueue));
+    printf("TERMINATING: queueSpsc_runTest()\n");
+}
+
+#ifdef QUEUESPSC_HOST_MAIN
+// Run the consumer on its own host thread.
+static void *queueSpsc_hostThread(void *arg) {
+    ((void (*)(void))arg)();
+    return NULL;
+}
+
+// Starts consumer on a detached host thread.
+static void queueSpsc_startHostThread(void (*consumer)(void)) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, queueSpsc_hostThread, (void *)consumer) != 0) {
+        printf("ERROR in queueSpsc_startHostThread(): Unable to create thread.\n");
+        abort();
+    }
+    pthread_detach(thread);
+}
+
+// Stand-alone host stress test, see queueSpsc.h.
+int main() {
+    queueSpsc_runTest(queueSpsc_startHostThread);
+    return 0;
+}
+#endif
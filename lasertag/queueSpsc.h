@@ -0,0 +1,88 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef QUEUESPSC_H_
+#define QUEUESPSC_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "queue.h"
+
+// Concurrent single-producer/single-consumer (SPSC) queue. Unlike queue_t it
+// has no shared elementCount: the producer only writes indexIn and the
+// consumer only writes indexOut, published with C11 release stores and read
+// with acquire loads. One context (ISR, main loop, or core) may push while
+// another pops without masking interrupts or taking locks.
+// Elements are any fixed-size type (samples, event structs), copied in and
+// out with memcpy(). Storage is provided by the caller.
+// Works on the Zynq (both cores, the SCU keeps the caches coherent) and on a
+// host, where it can be stress-tested with a producer and a consumer thread:
+//   gcc -DQUEUESPSC_HOST_MAIN -I. queueSpsc.c -lpthread
+
+typedef struct {
+    // Producer side, on its own cache line. indexIn is free-running and is
+    // only masked when the data array is accessed.
+    _Atomic queue_index_t indexIn __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+    queue_index_t producerIndexOutCache; // Last indexOut the producer loaded.
+    _Atomic uint32_t refusedCount;
+
+    // Consumer side, on its own cache line.
+    _Atomic queue_index_t indexOut __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+    queue_index_t consumerIndexInCache; // Last indexIn the consumer loaded.
+
+    // Set by queueSpsc_init(), then read-only.
+    uint8_t *data __attribute__((aligned(QUEUE_CACHE_LINE_SIZE)));
+    queue_size_t size; // Capacity in elements, a power of two.
+    uint32_t elementSize; // Bytes per element.
+    char name[QUEUE_MAX_NAME_SIZE];
+} queueSpsc_t;
+
+// Initializes an empty queue on caller-provided storage of size * elementSize
+// bytes. size must be a power of two, calls abort() otherwise. Call before the
+// producer and consumer start.
+void queueSpsc_init(queueSpsc_t *q, void *storage, queue_size_t size, uint32_t elementSize,
+                    const char *name);
+
+// Producer only. Copies element into the queue. Returns false and counts a
+// refused element if the queue is full.
+bool queueSpsc_push(queueSpsc_t *q, const void *element);
+
+// Consumer only. Copies the oldest element into element and removes it.
+// Returns false if the queue is empty.
+bool queueSpsc_pop(queueSpsc_t *q, void *element);
+
+// Producer only. Pushes up to n elements from src with at most two memcpy()
+// segments. Elements that do not fit are counted as refused. Returns the
+// number pushed.
+queue_size_t queueSpsc_pushBlock(queueSpsc_t *q, const void *src, queue_size_t n);
+
+// Consumer only. Pops up to n elements into dst with at most two memcpy()
+// segments. Returns the number popped.
+queue_size_t queueSpsc_popBlock(queueSpsc_t *q, void *dst, queue_size_t n);
+
+// Returns the number of queued elements. Safe from either side; the value can
+// be stale by the time it is used.
+queue_size_t queueSpsc_elementCount(queueSpsc_t *q);
+
+// Returns the number of elements refused because the queue was full. They are
+// lost unless the producer retries them, so this is the drop count of a
+// producer that never retries (e.g. an ISR).
+uint32_t queueSpsc_refusedCount(queueSpsc_t *q);
+
+// Get the user-assigned name for the queue.
+const char *queueSpsc_name(queueSpsc_t *q);
+
+// Pushes a sequence through a queue to a consumer started with
+// startConsumer() and checks that it arrives complete and in order. Pass
+// interCore_startCore1 to run the consumer on core 1 (a thread on a host).
+void queueSpsc_runTest(void (*startConsumer)(void (*consumer)(void)));
+
+#endif /* QUEUESPSC_H_ */
@@ -0,0 +1,178 @@
+//
+// Type-generic queue declarations. Do not include this file directly, include
+// queue.h. queue.h includes it once per payload type with these defined:
+//   QUEUE_T       the queue struct type, e.g. queue_f32_t.
+//   QUEUE_DATA_T  the element type, e.g. queue_f32_data_t.
+//   QUEUE_FN(f)   the function name for f, e.g. queue_f32_##f.
+// The definitions are in queueTemplateImpl.h, which is included by queue.c.
+// No include guard on purpose.
+//
+
+#if !defined(QUEUE_T) || !defined(QUEUE_DATA_T) || !defined(QUEUE_FN)
+#error "Define QUEUE_T, QUEUE_DATA_T and QUEUE_FN before including queueTemplate.h"
+#endif
+
+// The queue struct with elementCount to speed up computations to determine
+// element count. Queue will use the empty location and pointer arithmetic to
+// determine full and empty.
+// The fields used by push/pop come first and the struct is cache-line aligned,
+// so they share one line; the debug name and ownership flag come after.
+typedef struct {
+    // Points to the storage array (malloc'd or caller-provided).
+    QUEUE_DATA_T *data;
+
+    // Always points to the next open slot.
+    queue_index_t indexIn;
+
+    // Always points to the next element to be removed
+    // from the queue (or "oldest" element).
+    queue_index_t indexOut;
+
+    // Keep track of the number of elements currently in queue.
+    queue_size_t elementCount;
+
+    // This is the capacity of the queue, in elements. A mirrored queue's
+    // data array is twice as long.
+    queue_size_t size;
+
+    // True if initialized with queue_initMirrored(). Every value is then
+    // stored twice, at data[i] and data[i + size], so the newest elements are
+    // always contiguous (see queue_window()).
+    bool mirrored;
+
+    // True if queue_pop() is called on an empty queue. Reset
+    // to false after queue_push() is called.
+    bool underflowFlag;
+
+    // True if queue_push() is called on a full queue. Reset to
+    // false once queue_pop() is called.
+    bool overflowFlag;
+
+    // Cold fields below.
+
+    // Values lost to overflow / missing on underflow since initialization,
+    // see queue_overflowCount() and queue_underflowCount().
+    uint32_t overflowCount;
+    uint32_t underflowCount;
+
+    // True if data was malloc'd by queue_init() and must be freed by
+    // queue_garbageCollect().
+    bool ownsData;
+
+    // Name for debugging purposes.
+    char name[QUEUE_MAX_NAME_SIZE];
+} __attribute__((aligned(QUEUE_CACHE_LINE_SIZE))) QUEUE_T;
+
+// Initializes the queue on caller-provided storage of at least size elements
+// (e.g. a static array) instead of malloc'ing it. The queue is empty after
+// initialization. queue_garbageCollect() does not free the storage. Calling
+// it again on the same storage resets the queue, nothing leaks.
+void QUEUE_FN(initStatic)(QUEUE_T *q, QUEUE_DATA_T *storage, queue_size_t size,
+                          const char *name);
+
+// Same as queue_initStatic() for a mirrored queue (see queue_initMirrored()).
+// size must be a power of two and storage must hold 2 * size elements. Calls
+// abort() if size is not a power of two.
+void QUEUE_FN(initMirroredStatic)(QUEUE_T *q, QUEUE_DATA_T *storage,
+                                  queue_size_t size, const char *name);
+
+// Allocates memory for the queue (the data* pointer) and initializes all
+// parts of the data structure. Prints out an error message if malloc() fails
+// and calls assert(false) to print-out line-number information and die.
+// The queue is empty after initialization. To fill the queue with known
+// values (e.g. zeros), call queue_overwritePush() up to queue_size() times.
+void QUEUE_FN(init)(QUEUE_T *q, queue_size_t size, const char *name);
+
+// Same as queue_init() but size must be a power of two, and the data array
+// holds every value twice (2 * size elements) so that queue_window() can
+// return the newest elements as one contiguous array. Also speeds up
+// queue_readElementAt(). Calls abort() if size is not a power of two.
+void QUEUE_FN(initMirrored)(QUEUE_T *q, queue_size_t size, const char *name);
+
+// Returns a pointer to the newest n elements of a mirrored queue as a
+// contiguous array, oldest first (the newest element is at [n - 1]). The
+// pointer is valid until the next push or pop. Prints an error and returns
+// NULL if the queue is not mirrored or holds fewer than n elements.
+const QUEUE_DATA_T *QUEUE_FN(window)(QUEUE_T *q, queue_size_t n);
+
+// Get the user-assigned name for the queue.
+const char *QUEUE_FN(name)(QUEUE_T *q);
+
+// Returns the capacity of the queue.
+queue_size_t QUEUE_FN(size)(QUEUE_T *q);
+
+// Returns true if the queue is full.
+bool QUEUE_FN(full)(QUEUE_T *q);
+
+// Returns true if the queue is empty.
+bool QUEUE_FN(empty)(QUEUE_T *q);
+
+// If the queue is not full, pushes a new element into the queue and clears the
+// underflowFlag. IF the queue is full, set the overflowFlag, print an error
+// message and DO NOT change the queue.
+void QUEUE_FN(push)(QUEUE_T *q, QUEUE_DATA_T value);
+
+// If the queue is not empty, remove and return the oldest element in the queue.
+// If the queue is empty, set the underflowFlag, print an error message, and DO
+// NOT change the queue.
+QUEUE_DATA_T QUEUE_FN(pop)(QUEUE_T *q);
+
+// If the queue is full, call queue_pop() and then call queue_push().
+// If the queue is not full, just call queue_push().
+void QUEUE_FN(overwritePush)(QUEUE_T *q, QUEUE_DATA_T value);
+
+// Block operations. Each moves n elements with at most two memcpy() segments
+// (wrap-around) and checks for room once. Unlike queue_push() and queue_pop()
+// they never print; overflow and underflow are counted instead (see
+// queue_overflowCount() and queue_underflowCount()).
+
+// Pushes up to n values from src, oldest first. Values that do not fit are
+// dropped, counted, and set the overflowFlag. Returns the number pushed.
+queue_size_t QUEUE_FN(pushBlock)(QUEUE_T *q, const QUEUE_DATA_T *src,
+                                 queue_size_t n);
+
+// Pops up to n of the oldest elements into dst (or drops them if dst is NULL).
+// A shortfall is counted and sets the underflowFlag. Returns the number popped.
+queue_size_t QUEUE_FN(popBlock)(QUEUE_T *q, QUEUE_DATA_T *dst,
+                                queue_size_t n);
+
+// Same as queue_overwritePush() for each of the n values in src. If n is
+// larger than the queue, only the newest queue_size() values are kept.
+void QUEUE_FN(overwritePushBlock)(QUEUE_T *q, const QUEUE_DATA_T *src,
+                                  queue_size_t n);
+
+// Copies the n elements starting at index start (0 is the oldest, as in
+// queue_readElementAt()) into dst without removing them. Elements past the
+// newest one are not copied but counted as underflow. Returns the number
+// copied.
+queue_size_t QUEUE_FN(copyRange)(QUEUE_T *q, QUEUE_DATA_T *dst,
+                                 queue_index_t start, queue_size_t n);
+
+// Provides random-access read capability to the queue.
+// Low-valued indexes access older queue elements while higher-value indexes
+// access newer elements (according to the order that they were added). Print a
+// meaningful error message if an error condition is detected.
+QUEUE_DATA_T QUEUE_FN(readElementAt)(QUEUE_T *q, queue_index_t index);
+
+// Returns a count of the elements currently contained in the queue.
+queue_size_t QUEUE_FN(elementCount)(QUEUE_T *q);
+
+// Returns true if an underflow has occurred (queue_pop() called on an empty
+// queue).
+bool QUEUE_FN(underflow)(QUEUE_T *q);
+
+// Returns true if an overflow has occurred (queue_push() called on a full
+// queue).
+bool QUEUE_FN(overflow)(QUEUE_T *q);
+
+// Returns the number of values that could not be pushed because the queue was
+// full, since initialization.
+uint32_t QUEUE_FN(overflowCount)(QUEUE_T *q);
+
+// Returns the number of values that could not be popped or copied because the
+// queue held too few, since initialization.
+uint32_t QUEUE_FN(underflowCount)(QUEUE_T *q);
+
+// Frees the storage that you malloc'd before. Does nothing for storage passed
+// to queue_initStatic().
+void QUEUE_FN(garbageCollect)(QUEUE_T *q);
@@ -0,0 +1,358 @@
+//
+// Type-generic queue definitions, see queueTemplate.h for the parameters.
+// Included by queue.c once per payload type, after queue.h. Only use
+// QUEUE_FN() names here so that every instantiation gets its own functions.
+// No include guard on purpose.
+//
+
+#if !defined(QUEUE_T) || !defined(QUEUE_DATA_T) || !defined(QUEUE_FN)
+#error "Define QUEUE_T, QUEUE_DATA_T and QUEUE_FN before including queueTemplateImpl.h"
+#endif
+
+// Initializes the queue on caller-provided storage of at least size elements.
+// Does not allocate; queue_garbageCollect() leaves the storage alone. Can be
+// called again on the same storage to reset the queue (e.g. on restart).
+void QUEUE_FN(initStatic)(QUEUE_T *q, QUEUE_DATA_T *storage, queue_size_t size,
+                          const char *name) {
+  // Not mirrored, see queue_initMirrored().
+  q->mirrored = false;
+  // Always points to the next open slot.
+  q->indexIn = 0;
+  // Always points to the next element to be removed
+  // from the queue (or "oldest" element).
+  q->indexOut = 0;
+  // Keep track of the number of elements currently in queue.
+  q->elementCount = 0;
+  // Queue capacity.
+  q->size = size;
+  // Points to the storage array.
+  q->data = storage;
+  // The caller owns the storage.
+  q->ownsData = false;
+  // Nothing lost yet.
+  q->overflowCount = 0;
+  q->underflowCount = 0;
+  // True if queue_pop() is called on an empty queue. Reset
+  // to false after queue_push() is called.
+  q->underflowFlag = false;
+  // True if queue_push() is called on a full queue. Reset to
+  // false once queue_pop() is called.
+  q->overflowFlag = false;
+  // Name for debugging purposes.
+  strncpy(q->name, name, QUEUE_MAX_NAME_SIZE);
+  q->name[QUEUE_MAX_NAME_SIZE - 1] = '\0';
+}
+
+// Same as queue_initStatic() but for a mirrored queue (see
+// queue_initMirrored()): size must be a power of two and storage must hold
+// 2 * size elements. Calls abort() if size is not a power of two.
+void QUEUE_FN(initMirroredStatic)(QUEUE_T *q, QUEUE_DATA_T *storage,
+                                  queue_size_t size, const char *name) {
+  if (size == 0 || (size & (size - 1)) != 0)
+    abort();
+  QUEUE_FN(initStatic)(q, storage, size, name);
+  q->mirrored = true;
+}
+
+// Allocates memory for the queue (the data* pointer) and initializes all
+// parts of the data structure. Prints out an error message if malloc() fails
+// and calls assert(false) to print-out line-number information and die.
+// The queue is empty after initialization. To fill the queue with known
+// values (e.g. zeros), call queue_overwritePush() up to queue_size() times.
+void QUEUE_FN(init)(QUEUE_T *q, queue_size_t size, const char *name) {
+  QUEUE_DATA_T *storage = malloc(size * sizeof(QUEUE_DATA_T));
+  if (storage == NULL)
+    abort();
+  QUEUE_FN(initStatic)(q, storage, size, name);
+  q->ownsData = true;
+}
+
+// Same as queue_init() but size must be a power of two, and the data array
+// holds every value twice (2 * size elements) so that queue_window() can
+// return the newest elements as one contiguous array. Calls abort() if size is
+// not a power of two.
+void QUEUE_FN(initMirrored)(QUEUE_T *q, queue_size_t size, const char *name) {
+  if (size == 0 || (size & (size - 1)) != 0)
+    abort();
+  // Room for the mirror copy.
+  QUEUE_DATA_T *storage = malloc(2 * size * sizeof(QUEUE_DATA_T));
+  if (storage == NULL)
+    abort();
+  QUEUE_FN(initMirroredStatic)(q, storage, size, name);
+  q->ownsData = true;
+}
+
+// Returns a pointer to the newest n elements of a mirrored queue as a
+// contiguous array, oldest first. Valid until the next push or pop.
+const QUEUE_DATA_T *QUEUE_FN(window)(QUEUE_T *q, queue_size_t n) {
+  if (!q->mirrored || n > q->elementCount) {
+    printf("ERROR in queue_window(): %s cannot provide %u elements.\n",
+           q->name, n);
+    return NULL;
+  }
+  // indexIn < size and n <= size, so this stays inside the mirrored array.
+  return &q->data[q->indexIn + q->size - n];
+}
+
+// Get the user-assigned name for the queue.
+const char *QUEUE_FN(name)(QUEUE_T *q) { return q->name; }
+
+// Returns the capacity of the queue.
+queue_size_t QUEUE_FN(size)(QUEUE_T *q) { return q->size; }
+
+// Returns true if the queue is full.
+bool QUEUE_FN(full)(QUEUE_T *q) { return q->elementCount == q->size; }
+
+// Returns true if the queue is empty.
+bool QUEUE_FN(empty)(QUEUE_T *q) { return q->elementCount == 0; }
+
+// If the queue is not full, pushes a new element into the queue and clears the
+// underflowFlag. IF the queue is full, set the overflowFlag, print an error
+// message and DO NOT change the queue.
+void QUEUE_FN(push)(QUEUE_T *q, QUEUE_DATA_T value) {
+  // Check for a full queue
+  if (QUEUE_FN(full)(q)) {
+    // IF the queue is full, set the overflowFlag, print an error
+    // message and DO NOT change the queue.
+    q->overflowFlag = true;
+    q->overflowCount++;
+    printf("ERROR in queue_push(): Queue is full. Unable to push.\n");
+    return;
+  }
+
+  // If the queue is not full, push the new element to the queue and clear the
+  // underflowFlag.
+  q->data[q->indexIn] = value;
+  // Keep the mirror copy up to date.
+  if (q->mirrored)
+    q->data[q->indexIn + q->size] = value;
+
+  // Increment element number and indexIn
+  q->elementCount++;
+
+  q->indexIn++;
+  if ((q->indexIn) >= q->size) {
+    q->indexIn = 0;
+  }
+
+  // Reset to false once queue_push is called
+  q->underflowFlag = false;
+}
+
+// If the queue is not empty, remove and return the oldest element in the queue.
+// If the queue is empty, set the underflowFlag, print an error message, and DO
+// NOT change the queue.
+QUEUE_DATA_T QUEUE_FN(pop)(QUEUE_T *q) {
+  // Check for an empty queue
+  if (QUEUE_FN(empty)(q)) {
+    // IF the queue is empty, set the underflowFlag, print an error
+    // message and DO NOT change the queue.
+    q->underflowFlag = true;
+    q->underflowCount++;
+    printf("ERROR in queue_pop(): Queue is empty. Unable to pop.\n");
+    return ((QUEUE_DATA_T)0);
+  }
+
+  // If the queue is not empty, remove and return the oldest element in the
+  // queue.
+  QUEUE_DATA_T extractedData = q->data[q->indexOut];
+
+  // Decrement element number and increment indexOut
+  q->elementCount--;
+  q->indexOut++;
+  if ((q->indexOut) >= q->size) {
+    q->indexOut = 0;
+  }
+
+  // Reset to false once queue_pop is called
+  q->overflowFlag = false;
+
+  return extractedData;
+}
+
+// If the queue is full, call queue_pop() and then call queue_push().
+// If the queue is not full, just call queue_push().
+void QUEUE_FN(overwritePush)(QUEUE_T *q, QUEUE_DATA_T value) {
+  // If the queue is full, call queue_pop() and then call queue_push().
+  if (QUEUE_FN(full)(q)) {
+    QUEUE_FN(pop)(q);
+  }
+
+  // If the queue is not full, just call queue_push().
+  QUEUE_FN(push)(q, value);
+}
+
+// Copies n values from src into the slots starting at indexIn and advances
+// indexIn. Takes at most two memcpy() segments (plus two for the mirror copy).
+// The caller has checked that there is room.
+static void QUEUE_FN(copyIn)(QUEUE_T *q, const QUEUE_DATA_T *src,
+                             queue_size_t n) {
+  // Elements that fit before the end of the array, the rest wrap to 0.
+  queue_size_t first = q->size - q->indexIn;
+  if (first > n)
+    first = n;
+  memcpy(&q->data[q->indexIn], src, first * sizeof(QUEUE_DATA_T));
+  memcpy(q->data, src + first, (n - first) * sizeof(QUEUE_DATA_T));
+  if (q->mirrored) {
+    memcpy(&q->data[q->indexIn + q->size], src, first * sizeof(QUEUE_DATA_T));
+    memcpy(&q->data[q->size], src + first, (n - first) * sizeof(QUEUE_DATA_T));
+  }
+  q->indexIn += n;
+  if (q->indexIn >= q->size)
+    q->indexIn -= q->size;
+  q->elementCount += n;
+}
+
+// Copies n elements, starting start elements after the oldest one, into dst.
+// Takes at most two memcpy() segments, one for a mirrored queue. The caller
+// has checked that start + n <= elementCount. dst may be NULL to skip the copy.
+static void QUEUE_FN(copyOut)(QUEUE_T *q, QUEUE_DATA_T *dst,
+                              queue_index_t start, queue_size_t n) {
+  if (dst == NULL)
+    return;
+  queue_index_t index = q->indexOut + start;
+  // A mirrored queue holds every element up to 2 * size contiguously.
+  if (q->mirrored) {
+    memcpy(dst, &q->data[index], n * sizeof(QUEUE_DATA_T));
+    return;
+  }
+  if (index >= q->size)
+    index -= q->size;
+  queue_size_t first = q->size - index;
+  if (first > n)
+    first = n;
+  memcpy(dst, &q->data[index], first * sizeof(QUEUE_DATA_T));
+  memcpy(dst + first, q->data, (n - first) * sizeof(QUEUE_DATA_T));
+}
+
+// Drops the n oldest elements. The caller has checked that n <= elementCount.
+static void QUEUE_FN(discard)(QUEUE_T *q, queue_size_t n) {
+  q->indexOut += n;
+  if (q->indexOut >= q->size)
+    q->indexOut -= q->size;
+  q->elementCount -= n;
+}
+
+// Pushes up to n values from src, oldest first. Values that do not fit are
+// dropped: sets the overflowFlag and adds them to queue_overflowCount(), but
+// does not print. Clears the underflowFlag if anything was pushed. Returns the
+// number of values pushed.
+queue_size_t QUEUE_FN(pushBlock)(QUEUE_T *q, const QUEUE_DATA_T *src,
+                                 queue_size_t n) {
+  queue_size_t room = q->size - q->elementCount;
+  if (n > room) {
+    q->overflowFlag = true;
+    q->overflowCount += n - room;
+    n = room;
+  }
+  if (n > 0) {
+    QUEUE_FN(copyIn)(q, src, n);
+    q->underflowFlag = false;
+  }
+  return n;
+}
+
+// Pops up to n of the oldest elements into dst (dst may be NULL to just drop
+// them). If fewer than n are queued: sets the underflowFlag and adds the
+// shortfall to queue_underflowCount(), but does not print. Clears the
+// overflowFlag if anything was popped. Returns the number of elements popped.
+queue_size_t QUEUE_FN(popBlock)(QUEUE_T *q, QUEUE_DATA_T *dst,
+                                queue_size_t n) {
+  if (n > q->elementCount) {
+    q->underflowFlag = true;
+    q->underflowCount += n - q->elementCount;
+    n = q->elementCount;
+  }
+  if (n > 0) {
+    QUEUE_FN(copyOut)(q, dst, 0, n);
+    QUEUE_FN(discard)(q, n);
+    q->overflowFlag = false;
+  }
+  return n;
+}
+
+// Same as calling queue_overwritePush() for each of the n values in src, but
+// with block copies. If n is larger than the queue, only the newest size
+// values are kept. Never overflows.
+void QUEUE_FN(overwritePushBlock)(QUEUE_T *q, const QUEUE_DATA_T *src,
+                                  queue_size_t n) {
+  if (n > q->size) {
+    src += n - q->size;
+    n = q->size;
+  }
+  queue_size_t room = q->size - q->elementCount;
+  if (n > room) {
+    QUEUE_FN(discard)(q, n - room);
+    q->overflowFlag = false;
+  }
+  if (n > 0) {
+    QUEUE_FN(copyIn)(q, src, n);
+    q->underflowFlag = false;
+  }
+}
+
+// Copies n elements into dst without removing them. start is the index of the
+// first element, as in queue_readElementAt() (0 is the oldest). If the range
+// runs past the newest element, only the available elements are copied and the
+// rest is added to queue_underflowCount(). Returns the number copied.
+queue_size_t QUEUE_FN(copyRange)(QUEUE_T *q, QUEUE_DATA_T *dst,
+                                 queue_index_t start, queue_size_t n) {
+  queue_size_t available =
+      start < q->elementCount ? q->elementCount - start : 0;
+  if (n > available) {
+    q->underflowCount += n - available;
+    n = available;
+  }
+  if (n > 0)
+    QUEUE_FN(copyOut)(q, dst, start, n);
+  return n;
+}
+
+// Provides random-access read capability to the queue.
+// Low-valued indexes access older queue elements while higher-value indexes
+// access newer elements (according to the order that they were added). Print a
+// meaningful error message if an error condition is detected.
+QUEUE_DATA_T QUEUE_FN(readElementAt)(QUEUE_T *q, queue_index_t index) {
+  // If the index does not refer to a queued element,
+  // return the appropriate error message
+  if (index >= q->elementCount) {
+    printf("ERROR in queue_readElementAt(): Index out of bounds.\n");
+    return ((QUEUE_DATA_T)0);
+  }
+
+  // A mirrored queue needs no wrap-around, its data array is twice as long.
+  if (q->mirrored)
+    return q->data[q->indexOut + index];
+
+  // Wrap around the end of the data array.
+  queue_index_t actualIndex = (index + q->indexOut) % q->size;
+  return q->data[actualIndex];
+}
+
+// Returns a count of the elements currently contained in the queue.
+queue_size_t QUEUE_FN(elementCount)(QUEUE_T *q) { return q->elementCount; }
+
+// Returns true if an underflow has occurred (queue_pop() called on an empty
+// queue).
+bool QUEUE_FN(underflow)(QUEUE_T *q) { return q->underflowFlag; }
+
+// Returns true if an overflow has occurred (queue_push() called on a full
+// queue).
+bool QUEUE_FN(overflow)(QUEUE_T *q) { return q->overflowFlag; }
+
+// Returns the number of values that could not be pushed because the queue was
+// full, since initialization.
+uint32_t QUEUE_FN(overflowCount)(QUEUE_T *q) { return q->overflowCount; }
+
+// Returns the number of values that could not be popped or copied because the
+// queue held too few, since initialization.
+uint32_t QUEUE_FN(underflowCount)(QUEUE_T *q) { return q->underflowCount; }
+
+// Frees the storage that you malloc'd before. Does nothing for storage passed
+// to queue_initStatic().
+void QUEUE_FN(garbageCollect)(QUEUE_T *q) {
+  if (q->ownsData)
+    free(q->data);
+  q->data = NULL;
+  q->ownsData = false;
+}
@@ -38,6 +38,10 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define I2S_RX_FIFO_REG 0x28
 #define I2S_TX_FIFO_REG 0x2C
 
+/* I2S_FIFO_STS_REG bits */
+#define I2S_FIFO_STS_TX_EMPTY 0b0001
+#define I2S_FIFO_STS_TX_FULL 0b0010
+
 /* IIC address of the SSM2603 device and the desired IIC clock speed */
 #define IIC_SLAVE_ADDR 0b0011010
 #define IIC_SCLK_RATE 100000
@@ -91,6 +95,9 @@ typedef enum {
 
 volatile static sound_st_t currentState = sound_init_st;
 
+// Number of sound_tick() calls that found the TX FIFO empty mid-sound.
+volatile static uint32_t sound_fifoUnderrunCount = 0;
+
 // Reset the TX FIFO.
 static void sound_resetTxFifo() {
   Xil_Out32(AUDIO_CTRL_BASEADDR + I2S_RESET_REG, 0b010); // Reset TX Fifo
@@ -120,6 +127,7 @@ sound_status_t sound_init() {
   // Setup the audio CODEC.
   AudioInitialize(SCU_TIMER_ID, AUDIO_IIC_ID, AUDIO_CTRL_BASEADDR);
   sound_initFlag = true;
+  sound_fifoUnderrunCount = 0;
   // Initialize the silence array.
   for (uint32_t i = 0; i < ONE_SECOND_OF_SOUND_ARRAY_SIZE; i++)
     soundOfSilence[i] = NO_SOUND;
@@ -198,16 +206,23 @@ void sound_tick() {
     }
     break;
   case sound_play_st:
-    // Each time you enter this state, add as many samples as will fit in the
-    // FIFO.
+    // Each time you enter this state, add up to SOUND_MAX_SAMPLES_PER_TICK
+    // samples, fewer if the FIFO fills up first.
     if (sound_array == NULL) {
       printf("ERROR, sound_tick: sound array has not been set.\n");
       return;
     }
-    // This while-loop continues to load sound-data into the FIFOs until it is
-    // full or the sound data are exhausted.
-    while (!(Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) &
-             0b0010)) { // while room in FIFO.
+    // An empty FIFO after the first call means the codec ran dry.
+    if (arrayIndex != 0 &&
+        (Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) & I2S_FIFO_STS_TX_EMPTY))
+      sound_fifoUnderrunCount++;
+    // This loop loads sound-data into the FIFOs until it is full, the sound
+    // data are exhausted or the per-call budget is used up.
+    for (uint32_t i = 0; i < SOUND_MAX_SAMPLES_PER_TICK &&
+                         currentState == sound_play_st &&
+                         !(Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) &
+                           I2S_FIFO_STS_TX_FULL); // while room in FIFO.
+         i++) {
       uint32_t sampleValue =
           sound_array[arrayIndex] * sound_currentVolume; // Scale by volume.
       sound_sendDataToBothChannels(
@@ -223,6 +238,10 @@ void sound_tick() {
   }
 }
 
+// Returns the number of sound_tick() calls that found the TX FIFO empty while
+// a sound was playing, since sound_init().
+uint32_t sound_getFifoUnderrunCount() { return sound_fifoUnderrunCount; }
+
 // Sets the sound and starts playing it immediately.
 void sound_playSound(sound_sounds_t sound) {
   sound_setSound(sound); // Set the sound to be played.
@@ -355,6 +374,7 @@ void sound_runTest() {
     if (!sound_isBusy())
       break;
   }
+  printf("FIFO underruns: %d\n", sound_getFifoUnderrunCount());
   printf("done.\n");
 }
 
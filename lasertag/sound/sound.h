@@ -12,11 +12,21 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "isr.h"
 
 typedef uint32_t sound_status_t;
 #define SOUND_STATUS_OK 0
 #define SOUND_STATUS_FAIL 1
 
+// Timer interrupts between sound_tick() calls (100 us), see isr_init(). Each
+// call tops up the TX FIFO; 100 us is about 5 samples at 48 kHz.
+#define SOUND_TICK_PERIOD (ISR_TICKS_PER_MILLISECOND / 10)
+
+// Most samples sound_tick() writes to the TX FIFO per call, so its run time in
+// the ISR does not depend on the FIFO depth. Must stay above the ~5 samples
+// played per call; the margin refills the FIFO after a start or a late tick.
+#define SOUND_MAX_SAMPLES_PER_TICK 8
+
 // Sound levels.
 #define SOUND_VOLUME_0 (INT16_MAX / 64) // Min volume.
 #define SOUND_VOLUME_1 (INT16_MAX / 32)
@@ -55,6 +65,10 @@ void sound_waitForSoundToFinish();
 // Standard tick function.
 void sound_tick();
 
+// Returns the number of sound_tick() calls that found the TX FIFO empty while
+// a sound was playing (audible gaps), since sound_init().
+uint32_t sound_getFifoUnderrunCount();
+
 // Sets the sound and starts playing it immediately.
 void sound_playSound(sound_sounds_t sound);
 
@@ -13,6 +13,7 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "buffer.h"
 
 #define MAX_ERROR_CNT 5
+#define BLOCK_SIZE 100
 #define MARK(n) (n^0x8000)
 
 static uint32_t error_cnt;
@@ -28,9 +29,33 @@ static void check_value(buffer_data_t expected)
 	}
 }
 
+static void check_block(uint32_t first, uint64_t expectedIndex)
+{
+	const buffer_data_t *block;
+	uint64_t index;
+	uint32_t count = buffer_acquireBlock(&block, &index);
+
+	if (count != BUFFER_BLOCK_SIZE || ((uintptr_t)block % 32) != 0 || index != expectedIndex) {
+		printf(" -- error: block of %d values at %p, sample index %d\n", count, (void *)block, (uint32_t)index);
+		error_cnt++;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		if (block[i] != MARK((first+i))) {
+			if (error_cnt < MAX_ERROR_CNT)
+				printf(" -- error: expected: 0x%08X, found: 0x%08X\n", MARK((first+i)), block[i]);
+			error_cnt++;
+		}
+	}
+	if (!buffer_releaseBlock(count)) error_cnt++;
+}
+
 void buffer_runTest(void)
 {
-	uint32_t i, bsize, start;
+	uint32_t i, j, bsize, start, count;
+	buffer_data_t block[BLOCK_SIZE];
+	buffer_stats_t stats;
+	const buffer_data_t *inPlace;
+	uint64_t index, nextIndex;
 
 	buffer_init();
 	bsize = buffer_size();
@@ -62,6 +87,12 @@ void buffer_runTest(void)
 	start = 0x40;
 	error_cnt = 0;
 	for (i = start;   i < start+bsize+2; i++) buffer_pushover(MARK(i));
+	buffer_getStats(&stats);
+	if (stats.droppedCount != 2 || stats.longestOverflow != 2 || stats.highWaterMark != bsize) {
+		printf(" -- error: dropped %d, longest %d, high water %d\n",
+		       stats.droppedCount, stats.longestOverflow, stats.highWaterMark);
+		error_cnt++;
+	}
 	for (i = start+2; i < start+bsize+2; i++) check_value(MARK(i));
 	printf("errors: %d\n", error_cnt);
 
@@ -73,4 +104,39 @@ void buffer_runTest(void)
 	check_value(0);
 	check_value(0);
 	printf("errors: %d\n", error_cnt);
+
+	printf("wrapped over-fill and block drain test\n");
+	start = 0x60;
+	error_cnt = 0;
+	for (i = start; i < start+bsize/2; i++) buffer_pushover(MARK(i));
+	for (i = start; i < start+bsize/4; i++) check_value(MARK(i));
+	for (i = start+bsize/2; i < start+bsize+bsize/2; i++) buffer_pushover(MARK(i));
+	i = start+bsize/2;
+	nextIndex = buffer_getReadIndex();
+	while ((count = buffer_popBlock(block, BLOCK_SIZE, &index)) > 0) {
+		// The first block skips the values that were overwritten
+		if (i != start+bsize/2 && index != nextIndex) error_cnt++;
+		nextIndex = index + count;
+		for (j = 0; j < count; j++, i++) {
+			if (block[j] != MARK(i)) {
+				if (error_cnt < MAX_ERROR_CNT)
+					printf(" -- error: expected: 0x%08X, found: 0x%08X\n", MARK(i), block[j]);
+				error_cnt++;
+			}
+		}
+	}
+	if (i != start+bsize+bsize/2 || nextIndex != buffer_getSampleCount()) error_cnt++;
+	printf("errors: %d\n", error_cnt);
+
+	printf("block capture test\n");
+	start = 0x70;
+	error_cnt = 0;
+	buffer_init();
+	for (i = start; i < start+BUFFER_BLOCK_SIZE*3/2; i++) buffer_pushover(MARK(i));
+	check_block(start, 0);
+	// The second block is not complete yet
+	if (buffer_acquireBlock(&inPlace, NULL) != 0) error_cnt++;
+	for (i = start+BUFFER_BLOCK_SIZE*3/2; i < start+BUFFER_BLOCK_SIZE*2; i++) buffer_pushover(MARK(i));
+	check_block(start+BUFFER_BLOCK_SIZE, BUFFER_BLOCK_SIZE);
+	printf("errors: %d\n", error_cnt);
 }
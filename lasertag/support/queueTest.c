@@ -527,6 +527,181 @@ bool queue_overwritePushTest(void) {
   return testResult;
 }
 
+#define MIRRORED_TEST_QUEUE_SIZE 64 // Must be a power of two.
+#define MIRRORED_TEST_PUSH_COUNT 200 // Wraps the queue a few times.
+#define MIRRORED_TEST_QUEUE_NAME "mirroredQ"
+// Checks that a mirrored queue (queue_initMirrored()) returns the right
+// values from queue_window() and queue_readElementAt() after every
+// queue_overwritePush(), including when the newest values wrap around.
+bool queue_mirroredTest(void) {
+  bool testResult = true;
+  double dataArray[MIRRORED_TEST_PUSH_COUNT];
+  queue_t testQ;
+  queue_initMirrored(&testQ, MIRRORED_TEST_QUEUE_SIZE,
+                     MIRRORED_TEST_QUEUE_NAME);
+  for (uint16_t i = 0; i < MIRRORED_TEST_PUSH_COUNT && testResult; i++) {
+    dataArray[i] = (double)rand();
+    queue_overwritePush(&testQ, dataArray[i]);
+    queue_size_t count = queue_elementCount(&testQ);
+    // The whole window must match the newest values, oldest first.
+    const queue_data_t *window = queue_window(&testQ, count);
+    for (queue_size_t j = 0; j < count; j++) {
+      double expected = dataArray[i + 1 - count + j];
+      if (window[j] != expected ||
+          queue_readElementAt(&testQ, j) != expected) {
+        printf("* Error: %s[%u] is wrong after %u pushes.\n",
+               queue_name(&testQ), j, i + 1);
+        testResult = false;
+        break;
+      }
+    }
+  }
+  queue_garbageCollect(&testQ);
+  return testResult;
+}
+
+#define BLOCK_TEST_QUEUE_SIZE 64 // Power of two so it can also be mirrored.
+#define BLOCK_TEST_ITERATIONS 1000
+#define BLOCK_TEST_MAX_BLOCK 80 // Larger than the queue, to test clipping.
+#define BLOCK_TEST_QUEUE_NAME "blockQ"
+// Checks queue_pushBlock(), queue_popBlock(), queue_overwritePushBlock() and
+// queue_copyRange() on a plain and a mirrored queue against a reference queue
+// driven one element at a time with queue_overwritePush() and queue_pop().
+bool queue_blockTest(void) {
+  bool testResult = true;
+  queue_t refQ, plainQ, mirroredQ;
+  queue_init(&refQ, BLOCK_TEST_QUEUE_SIZE, "refQ");
+  queue_init(&plainQ, BLOCK_TEST_QUEUE_SIZE, BLOCK_TEST_QUEUE_NAME);
+  queue_initMirrored(&mirroredQ, BLOCK_TEST_QUEUE_SIZE, BLOCK_TEST_QUEUE_NAME);
+  queue_t *blockQs[] = {&plainQ, &mirroredQ};
+  double block[BLOCK_TEST_MAX_BLOCK];
+  double copy[BLOCK_TEST_MAX_BLOCK];
+  for (uint16_t i = 0; i < BLOCK_TEST_ITERATIONS && testResult; i++) {
+    queue_size_t n = rand() % BLOCK_TEST_MAX_BLOCK;
+    for (queue_size_t j = 0; j < n; j++)
+      block[j] = (double)rand();
+    switch (rand() % 3) {
+    case 0: // overwritePushBlock.
+      for (queue_size_t j = 0; j < n; j++)
+        queue_overwritePush(&refQ, block[j]);
+      for (uint16_t k = 0; k < 2; k++)
+        queue_overwritePushBlock(blockQs[k], block, n);
+      break;
+    case 1: { // pushBlock, only what fits.
+      queue_size_t room = BLOCK_TEST_QUEUE_SIZE - queue_elementCount(&refQ);
+      queue_size_t expected = n < room ? n : room;
+      for (queue_size_t j = 0; j < expected; j++)
+        queue_push(&refQ, block[j]);
+      for (uint16_t k = 0; k < 2; k++)
+        if (queue_pushBlock(blockQs[k], block, n) != expected ||
+            queue_overflowCount(blockQs[k]) != queue_overflowCount(&plainQ))
+          testResult = false;
+      break;
+    }
+    default: { // popBlock, only what is there.
+      queue_size_t count = queue_elementCount(&refQ);
+      queue_size_t expected = n < count ? n : count;
+      for (queue_size_t j = 0; j < expected; j++)
+        block[j] = queue_pop(&refQ);
+      for (uint16_t k = 0; k < 2; k++) {
+        if (queue_popBlock(blockQs[k], copy, n) != expected)
+          testResult = false;
+        for (queue_size_t j = 0; j < expected; j++)
+          if (copy[j] != block[j])
+            testResult = false;
+      }
+      break;
+    }
+    }
+    // Contents and a random copyRange() must match the reference.
+    queue_size_t count = queue_elementCount(&refQ);
+    queue_index_t start = count ? rand() % count : 0;
+    queue_size_t rangeCount = count - start;
+    for (uint16_t k = 0; k < 2; k++) {
+      if (queue_elementCount(blockQs[k]) != count ||
+          queue_copyRange(blockQs[k], copy, start, rangeCount) != rangeCount)
+        testResult = false;
+      for (queue_size_t j = 0; j < count; j++)
+        if (queue_readElementAt(blockQs[k], j) !=
+            queue_readElementAt(&refQ, j))
+          testResult = false;
+      for (queue_size_t j = 0; j < rangeCount; j++)
+        if (copy[j] != queue_readElementAt(&refQ, start + j))
+          testResult = false;
+    }
+    if (!testResult)
+      printf("* Error: block queues differ from %s after %u operations.\n",
+             queue_name(&refQ), i + 1);
+  }
+  // Copying past the newest element is counted, not printed.
+  uint32_t underflows = queue_underflowCount(&plainQ);
+  queue_copyRange(&plainQ, copy, queue_elementCount(&plainQ), 1);
+  if (queue_underflowCount(&plainQ) != underflows + 1)
+    testResult = false;
+  queue_garbageCollect(&refQ);
+  queue_garbageCollect(&plainQ);
+  queue_garbageCollect(&mirroredQ);
+  return testResult;
+}
+
+#define TYPED_TEST_QUEUE_SIZE 32 // Power of two so it can also be mirrored.
+#define TYPED_TEST_PUSH_COUNT 100
+#define TYPED_TEST_QUEUE_NAME "typedQ"
+// Generates queue_typedTest_<FN>(), a short test of one queue instantiation
+// (see queueTemplate.h): fill, overflow, empty, underflow, overwritePush()
+// wrap-around on static storage and queue_window(). Test values are small
+// integers so they are exact in every element type.
+#define QUEUE_TYPED_TEST(FN, QT, DT)                                           \
+  static bool queue_typedTest_##FN(void) {                                     \
+    bool result = true;                                                        \
+    DT values[TYPED_TEST_PUSH_COUNT];                                          \
+    QT q;                                                                      \
+    for (uint16_t i = 0; i < TYPED_TEST_PUSH_COUNT; i++)                       \
+      values[i] = (DT)(rand() % 2000 - 1000);                                  \
+    /* Fill, overflow, empty, underflow. */                                    \
+    FN##init(&q, TYPED_TEST_QUEUE_SIZE, TYPED_TEST_QUEUE_NAME);                \
+    for (uint16_t i = 0; i < TYPED_TEST_QUEUE_SIZE; i++)                       \
+      FN##push(&q, values[i]);                                                 \
+    FN##push(&q, values[0]);                                                   \
+    if (!FN##full(&q) || !FN##overflow(&q))                                    \
+      result = false;                                                          \
+    for (uint16_t i = 0; i < TYPED_TEST_QUEUE_SIZE; i++)                       \
+      if (FN##pop(&q) != values[i])                                            \
+        result = false;                                                        \
+    FN##pop(&q);                                                               \
+    if (!FN##empty(&q) || !FN##underflow(&q) || FN##overflow(&q))              \
+      result = false;                                                          \
+    FN##garbageCollect(&q);                                                    \
+    /* overwritePush() past the end, read back static and mirrored. */        \
+    QT mq;                                                                     \
+    DT storage[TYPED_TEST_QUEUE_SIZE];                                         \
+    FN##initStatic(&q, storage, TYPED_TEST_QUEUE_SIZE, TYPED_TEST_QUEUE_NAME); \
+    FN##initMirrored(&mq, TYPED_TEST_QUEUE_SIZE, TYPED_TEST_QUEUE_NAME);       \
+    for (uint16_t i = 0; i < TYPED_TEST_PUSH_COUNT; i++) {                     \
+      FN##overwritePush(&q, values[i]);                                        \
+      FN##overwritePush(&mq, values[i]);                                       \
+    }                                                                          \
+    const DT *window = FN##window(&mq, TYPED_TEST_QUEUE_SIZE);                 \
+    for (uint16_t i = 0; i < TYPED_TEST_QUEUE_SIZE; i++) {                     \
+      DT expected =                                                            \
+          values[TYPED_TEST_PUSH_COUNT - TYPED_TEST_QUEUE_SIZE + i];           \
+      if (FN##readElementAt(&q, i) != expected ||                              \
+          FN##readElementAt(&mq, i) != expected || window[i] != expected)      \
+        result = false;                                                        \
+    }                                                                          \
+    FN##garbageCollect(&q);                                                    \
+    FN##garbageCollect(&mq);                                                   \
+    printf("=== Queue: %s (%s, %u bytes per element) %s typed test.\n",        \
+           TYPED_TEST_QUEUE_NAME, #QT, (uint16_t)sizeof(DT),                   \
+           result ? "passed" : "failed");                                      \
+    return result;                                                             \
+  }
+
+QUEUE_TYPED_TEST(queue_, queue_t, queue_data_t)
+QUEUE_TYPED_TEST(queue_f32_, queue_f32_t, queue_f32_data_t)
+QUEUE_TYPED_TEST(queue_i16_, queue_i16_t, queue_i16_data_t)
+QUEUE_TYPED_TEST(queue_i32_, queue_i32_t, queue_i32_data_t)
+
 #define QUEUE_TEST_MAX_QUEUE_SIZE 100 // Used for the fill/empty tests.
 #define QUEUE_TEST_MAX_LOOP_COUNT                                              \
   10 // All tests will be invoked this many times.
@@ -628,6 +803,36 @@ bool queue_runTest(void) {
     } else {
       printf("=== Queue: %s failed overwritePush test.\n", queue_name(&testQ));
     }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing mirrored-queue test (queue_window()) === \n");
+    tempResult = queue_mirroredTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed mirrored-queue test.\n",
+             MIRRORED_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed mirrored-queue test.\n",
+             MIRRORED_TEST_QUEUE_NAME);
+    }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing block test (queue_pushBlock() etc.) === \n");
+    tempResult = queue_blockTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed block test.\n", BLOCK_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed block test.\n", BLOCK_TEST_QUEUE_NAME);
+    }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing typed-queue tests (every instantiation) === \n");
+    tempResult = queue_typedTest_queue_();
+    tempResult = queue_typedTest_queue_f32_() ? tempResult : false;
+    tempResult = queue_typedTest_queue_i16_() ? tempResult : false;
+    tempResult = queue_typedTest_queue_i32_() ? tempResult : false;
     testResult = tempResult
                      ? testResult
                      : false; // Logical AND of testResult and tempResult.
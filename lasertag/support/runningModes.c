@@ -13,6 +13,7 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdlib.h>
 #include <string.h>
 
+#include "adcJitter.h"
 #include "buffer.h"
 #include "buttons.h"
 #include "detector.h"
@@ -20,12 +21,16 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "filter.h"
 #include "histogram.h"
 #include "hitLedTimer.h"
+#include "interCore.h"
 #include "interrupts.h"
 #include "intervalTimer.h"
 #include "isr.h"
+#include "isrProfiler.h"
+#include "leds.h"
 #include "lockoutTimer.h"
 #include "runningModes.h"
 #include "switches.h"
+#include "timerService.h"
 #include "transmitter.h"
 #include "trigger.h"
 #include "utils.h"
@@ -61,6 +66,18 @@ void runningModes_printRunTimeStatistics(void) {
   display_printDecimalInt(remainingElementCount);
   display_print("\n\n");
 
+  // Print out the ADC buffer overflow telemetry.
+  buffer_stats_t bufferStats;
+  buffer_getStats(&bufferStats);
+  display_print("ADC buffer high-water mark: ");
+  display_printDecimalInt(bufferStats.highWaterMark);
+  display_print("\n\n");
+  display_print("ADC samples dropped: ");
+  display_printDecimalInt(bufferStats.droppedCount);
+  display_print(" (longest run ");
+  display_printDecimalInt(bufferStats.longestOverflow);
+  display_print(")\n\n");
+
   // Print out total running time in seconds.
   double runningSeconds = intervalTimer_getTotalDurationInSeconds(TOTAL_RUNTIME_TIMER);
   display_print("Measured run time in seconds: ");
@@ -68,7 +85,8 @@ void runningModes_printRunTimeStatistics(void) {
   display_print(sprintfBuffer);
   display_print("\n\n");
 
-  // Print out cumulative time spent in timer ISR.
+  // Print out cumulative time spent in timer ISR. The timer interrupt runs the
+  // top half, and the tick functions only when the main loop fell behind.
   double isrRunningSeconds =
       intervalTimer_getTotalDurationInSeconds(ISR_CUMULATIVE_TIMER);
   display_print("Cumulative run time in timer ISR: ");
@@ -79,17 +97,28 @@ void runningModes_printRunTimeStatistics(void) {
   display_print(sprintfBuffer);
   display_print("%)\n\n");
 
+  // Print out how far the tick functions fell behind the timer interrupt.
+  display_print("ISR bottom half max backlog: ");
+  display_printDecimalInt(isr_getBottomHalfMaxBacklog());
+  display_print(" interrupts, run ");
+  display_printDecimalInt(isr_getBottomHalfIsrRunCount());
+  display_print(" times from the timer ISR\n\n");
+
   // Print out cumulative time spent in detector.
-  double mainLoopRunningSeconds =
-      intervalTimer_getTotalDurationInSeconds(MAIN_CUMULATIVE_TIMER);
-  display_print("Cumulative run time in detector: ");
-  sprintf(sprintfBuffer, "%.2f", mainLoopRunningSeconds);
-  display_print(sprintfBuffer);
-  sprintf(sprintfBuffer, "%.2f",
-          mainLoopRunningSeconds / runningSeconds * 100);
-  display_print(" (");
-  display_print(sprintfBuffer);
-  display_print("%)\n\n");
+  if (RUNNING_MODES_MAIN_LOOP_TIMED) {
+    double mainLoopRunningSeconds =
+        intervalTimer_getTotalDurationInSeconds(MAIN_CUMULATIVE_TIMER);
+    display_print("Cumulative run time in detector: ");
+    sprintf(sprintfBuffer, "%.2f", mainLoopRunningSeconds);
+    display_print(sprintfBuffer);
+    sprintf(sprintfBuffer, "%.2f",
+            mainLoopRunningSeconds / runningSeconds * 100);
+    display_print(" (");
+    display_print(sprintfBuffer);
+    display_print("%)\n\n");
+  } else {
+    display_print("Run time in detector not measured (PWM transmitter).\n\n");
+  }
 
   // Print out total interrupt count.
   uint32_t interruptCount = interrupts_isrInvocationCount();
@@ -126,21 +155,64 @@ void runningModes_printRunTimeStatistics(void) {
     display_printDecimalInt(SUGGESTED_REMAINING_ELEMENT_COUNT);
     display_print(" elements.\n\n");
   }
+
+  // Sampling jitter and per-function ISR timing go to the console, they do
+  // not fit the display.
+  adcJitter_print();
+  if (ISR_PROFILER_ENABLED)
+    isrProfiler_print();
+}
+
+// Lights RUNNING_MODES_OVERFLOW_LEDS if samples were dropped since the last
+// call and, if printToConsole, prints the ADC buffer overflow telemetry at
+// most every RUNNING_MODES_OVERFLOW_REPORT_MS. Call it from a main loop to see
+// live which activity lets the ADC buffer overflow.
+void runningModes_reportBufferOverflows(bool printToConsole) {
+  static uint32_t seenDroppedCount = 0;
+  static uint32_t lastReportMs = 0;
+  buffer_stats_t stats;
+  buffer_getStats(&stats);
+  if (stats.droppedCount == seenDroppedCount)
+    return;
+  seenDroppedCount = stats.droppedCount;
+  leds_write(RUNNING_MODES_OVERFLOW_LEDS);
+  // The UART is slow and the buffer is already behind, so print rarely. Drops
+  // in between show up in the next report and in the run-time statistics.
+  uint32_t now = timerService_now();
+  if (!printToConsole || now - lastReportMs < RUNNING_MODES_OVERFLOW_REPORT_MS)
+    return;
+  lastReportMs = now;
+  printf("ADC buffer overflow: %d samples dropped (longest run %d), last at "
+         "%.2f s, high-water mark %d\n",
+         stats.droppedCount, stats.longestOverflow,
+         stats.lastOverflowPush / (FILTER_SAMPLE_FREQUENCY_IN_KHZ * 1000.0),
+         stats.highWaterMark);
 }
 
 // Group all of the inits together to reduce visual clutter.
 void runningModes_initAll(void) {
   // Assume mio, leds, buttons, switches, & display initialized previously
   histogram_init(HISTOGRAM_BAR_COUNT);
-  filter_init();
+  // In AMP mode the filters belong to core 1, see detector_startCore1()
+  if (!INTERCORE_AMP_MODE)
+    filter_init();
   detector_init();
   // isr_init() should include calls to: transmitter, trigger,
   // hitLedTimer, lockoutTimer, sound, and buffer init
   isr_init();
-  intervalTimer_initAll();
+  // Not intervalTimer_initAll(), it would stop the PWM transmitter carrier
+  if (RUNNING_MODES_MAIN_LOOP_TIMED) {
+    intervalTimer_initAll();
+  } else {
+    intervalTimer_init(ISR_CUMULATIVE_TIMER);
+    intervalTimer_init(TOTAL_RUNTIME_TIMER);
+  }
   // Init all interrupts (but does not enable the interrupts at the devices).
   // Call last
   interrupts_initAll(false); // A true argument enables error messages
+  // In AMP mode, the filters and detector run on core 1 (started only once)
+  if (INTERCORE_AMP_MODE)
+    detector_startCore1();
 }
 
 // Returns the current switch-setting
@@ -178,8 +250,9 @@ void runningModes_continuous(void) {
       ISR_CUMULATIVE_TIMER); // Used to measure ISR execution time.
   intervalTimer_reset(
       TOTAL_RUNTIME_TIMER); // Used to measure total program execution time.
-  intervalTimer_reset(
-      MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
+  if (RUNNING_MODES_MAIN_LOOP_TIMED)
+    intervalTimer_reset(
+        MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
   intervalTimer_start(
       TOTAL_RUNTIME_TIMER);   // Start measuring total execution time.
   interrupts_enableArmInts(); // ARM will now see interrupts after this.
@@ -188,14 +261,18 @@ void runningModes_continuous(void) {
   transmitter_run();           // Start the transmitter.
   while (!(buttons_read() &
            BUTTONS_BTN3_MASK)) { // Run until you detect BTN3 pressed.
+    isr_runBottomHalf(); // Run the tick functions for the elapsed interrupts.
     transmitter_setFrequencyNumber(runningModes_getFrequencySetting());
     histogramSystemTicks++;    // Keep track of ticks so you know when to update
                                // the histogram.
     // Run filters, compute power, etc.
-    intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
-                                                // doing something.
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
+                                                  // doing something.
     detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
-    intervalTimer_stop(MAIN_CUMULATIVE_TIMER);
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_stop(MAIN_CUMULATIVE_TIMER);
+    runningModes_reportBufferOverflows(true); // Show ADC buffer overflows live.
     // If enough ticks have transpired, update the histogram.
     if (histogramSystemTicks >= SYSTEM_TICKS_PER_HISTOGRAM_UPDATE) {
       double powerValues[FILTER_FREQUENCY_COUNT]; // Copy the current power
@@ -219,9 +296,14 @@ void runningModes_continuous(void) {
 // Press BTN0 or the gun-trigger to shoot.
 // Each shot is registered on the histogram on the TFT.
 // Transmit frequency is selected via the slide-switches.
-void runningModes_shooter(void) {
+// With multiHit, concurrent shooters are all credited (see
+// detector_setMultiHitMode()).
+static void runningModes_runShooter(bool multiHit) {
   uint16_t hitCount = 0;
   runningModes_initAll();
+  // Refused in AMP mode, core 1 only makes single-hit decisions
+  if (!detector_setMultiHitMode(multiHit))
+    return;
 
   // Init the ignored-frequencies so no frequencies are ignored.
   bool ignoredFrequencies[FILTER_FREQUENCY_COUNT];
@@ -232,6 +314,8 @@ void runningModes_shooter(void) {
   ignoredFrequencies[runningModes_getFrequencySetting()] = true;
 #endif
   detector_setIgnoredFrequencies(ignoredFrequencies);
+  // Hold the threshold and ignore our own frequency while we shoot.
+  detector_setSelfTransmitMode(detector_selfTransmitFreeze_e);
 
   trigger_enable(); // Makes the state machine responsive to the trigger.
   interrupts_enableTimerGlobalInts(); // Allow timer interrupts.
@@ -240,8 +324,9 @@ void runningModes_shooter(void) {
       ISR_CUMULATIVE_TIMER); // Used to measure ISR execution time.
   intervalTimer_reset(
       TOTAL_RUNTIME_TIMER); // Used to measure total program execution time.
-  intervalTimer_reset(
-      MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
+  if (RUNNING_MODES_MAIN_LOOP_TIMED)
+    intervalTimer_reset(
+        MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
   intervalTimer_start(
       TOTAL_RUNTIME_TIMER);   // Start measuring total execution time.
   interrupts_enableArmInts(); // ARM will now see interrupts after this.
@@ -250,23 +335,35 @@ void runningModes_shooter(void) {
 
   while ((!(buttons_read() & BUTTONS_BTN3_MASK)) &&
          hitCount < MAX_HIT_COUNT) { // Run until you detect BTN3 pressed.
+    isr_runBottomHalf(); // Run the tick functions for the elapsed interrupts.
     transmitter_setFrequencyNumber(
         runningModes_getFrequencySetting());    // Read the switches and switch
                                                 // frequency as required.
-    intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
-                                                // doing something.
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
+                                                  // doing something.
     // Run filters, compute power, run hit-detection.
     detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
     if (detector_hitPreviouslyDetected()) {           // Hit detected
       hitCount++;                           // increment the hit count.
+      // Time from the sample that completed the hit to now (not in AMP mode).
+      if (!INTERCORE_AMP_MODE)
+        printf("Hit on frequency %d, %.2f ms after its sample.\n",
+               detector_getFrequencyNumberOfLastHit(),
+               (buffer_getSampleCount() - detector_getSampleIndexOfLastHit()) /
+                   (double)FILTER_SAMPLE_FREQUENCY_IN_KHZ);
+      if (multiHit)
+        printf("Hit mask 0x%03x.\n", detector_getHitMaskOfLastHit());
       detector_clearHit();                  // Clear the hit.
       detector_hitCount_t
           hitCounts[DETECTOR_HIT_ARRAY_SIZE]; // Store the hit-counts here.
       detector_getHitCounts(hitCounts);       // Get the current hit counts.
       histogram_plotUserHits(hitCounts);      // Plot the hit counts on the TFT.
     }
-    intervalTimer_stop(
-        MAIN_CUMULATIVE_TIMER); // All done with actual processing.
+    if (RUNNING_MODES_MAIN_LOOP_TIMED)
+      intervalTimer_stop(
+          MAIN_CUMULATIVE_TIMER); // All done with actual processing.
+    runningModes_reportBufferOverflows(true); // Show ADC buffer overflows live.
   }
   interrupts_disableArmInts(); // Done with loop, disable the interrupts.
   hitLedTimer_turnLedOff();    // Save power :-)
@@ -274,6 +371,69 @@ void runningModes_shooter(void) {
   printf("Shooter mode terminated after detecting %d hits.\n", hitCount);
 }
 
+// Shooter mode with a single global lockout, see runningModes.h.
+void runningModes_shooter(void) { runningModes_runShooter(false); }
+
+// Shooter mode in multi-hit mode, see runningModes.h.
+void runningModes_shooterMultiHit(void) { runningModes_runShooter(true); }
+
+// Run this mode at startup with no shooters present.
+// Collects RUNNING_MODE_CALIBRATION_TICKS of band powers (after letting the
+// filters settle), tracking the largest max/median power ratio and the peak
+// power of each band. The smallest safe fudge factor is then selected and kept
+// by the detector (see detector_calibrateFudgeFactor()), and the peak band
+// powers (the noise floor) are plotted on the TFT.
+void runningModes_calibrate(void) {
+  runningModes_initAll();
+
+  // Don't ignore any frequency and don't report hits while calibrating.
+  bool ignoredFrequencies[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    ignoredFrequencies[i] = false;
+  detector_setIgnoredFrequencies(ignoredFrequencies);
+  detector_ignoreAllHits(true);
+
+  double peakPowerValues[FILTER_FREQUENCY_COUNT]; // Noise floor of each band.
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    peakPowerValues[i] = 0.0;
+  double maxRatio = 0.0; // Largest max/median power ratio seen.
+
+  printf("Calibrating, keep all shooters away.\n");
+  interrupts_enableTimerGlobalInts(); // Allow timer interrupts.
+  interrupts_startArmPrivateTimer();  // Start the private ARM timer running.
+  interrupts_enableArmInts(); // ARM will now see interrupts after this.
+  uint32_t startTicks = interrupts_isrInvocationCount();
+  uint32_t elapsedTicks = 0;
+  while (elapsedTicks < RUNNING_MODE_CALIBRATION_SETTLE_TICKS +
+                            RUNNING_MODE_CALIBRATION_TICKS) {
+    isr_runBottomHalf(); // Run the tick functions for the elapsed interrupts.
+    detector(INTERRUPTS_CURRENTLY_ENABLED); // Keep the filters running.
+    elapsedTicks = interrupts_isrInvocationCount() - startTicks;
+    // Wait until the power windows contain only real samples.
+    if (elapsedTicks < RUNNING_MODE_CALIBRATION_SETTLE_TICKS)
+      continue;
+    double powerValues[FILTER_FREQUENCY_COUNT];
+    if (INTERCORE_AMP_MODE)
+      detector_getCore1PowerValues(powerValues);
+    else
+      filter_getCurrentPowerValues(powerValues);
+    double ratio = detector_getMaxToMedianPowerRatio(powerValues);
+    if (ratio > maxRatio)
+      maxRatio = ratio;
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+      if (powerValues[i] > peakPowerValues[i])
+        peakPowerValues[i] = powerValues[i];
+  }
+  interrupts_disableArmInts(); // Done with loop, disable the interrupts.
+  detector_ignoreAllHits(false);
+
+  uint32_t index = detector_calibrateFudgeFactor(maxRatio);
+  histogram_plotUserFrequencyPower(peakPowerValues);
+  printf("Calibration: max/median noise ratio %.2f, fudge factor %d "
+         "(index %d).\n",
+         maxRatio, detector_getFudgeFactor(), index);
+}
+
 // This mode simply dumps raw ADC values to the console.
 // It can be used to determine if bipolar mode is working for the ADC.
 // Will loop forever. Stop the program with an external reset or Ctl-C.
@@ -10,7 +10,9 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #ifndef RUNNINGMODES_H_
 #define RUNNINGMODES_H_
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "transmitter.h"
 
 // Uncomment this code so that the code in the various modes will
 // ignore your own frequency. You still must properly implement
@@ -33,6 +35,12 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define MAIN_CUMULATIVE_TIMER                                                  \
   INTERVAL_TIMER_TIMER_2 // Used to compute cumulative run-time in main.
 
+// With TRANSMITTER_BACKEND_PWM the AXI timer behind MAIN_CUMULATIVE_TIMER
+// generates the transmitter carrier, so the main loop is not timed and that
+// timer is left alone.
+#define RUNNING_MODES_MAIN_LOOP_TIMED                                          \
+  (TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_PWM)
+
 #define SYSTEM_TICKS_PER_HISTOGRAM_UPDATE                                      \
   30000 // Update the histogram about 3 times per second.
 
@@ -49,6 +57,11 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // good performance.
 #define SUGGESTED_REMAINING_ELEMENT_COUNT 500
 
+// Calibration mode lets the filters settle for this many ISR ticks (0.5 s),
+// then collects band-power statistics for this many ISR ticks (5 s).
+#define RUNNING_MODE_CALIBRATION_SETTLE_TICKS 50000
+#define RUNNING_MODE_CALIBRATION_TICKS 500000
+
 // Defined to make things more readable.
 #define INTERRUPTS_CURRENTLY_ENABLED true
 #define INTERRUPTS_CURRENTLY_DISABLE false
@@ -63,6 +76,18 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // self-explanatory.
 void runningModes_printRunTimeStatistics(void);
 
+// LEDs lit once ADC samples have been dropped (LD3 - LD0 are otherwise unused).
+#define RUNNING_MODES_OVERFLOW_LEDS 0xF
+// Shortest time between two overflow reports on the console.
+#define RUNNING_MODES_OVERFLOW_REPORT_MS 1000
+
+// Lights RUNNING_MODES_OVERFLOW_LEDS if ADC samples were dropped since the
+// last call. If printToConsole, also prints the overflow telemetry, at most
+// every RUNNING_MODES_OVERFLOW_REPORT_MS so the UART does not slow the main
+// loop while the buffer is behind. Call it from a main loop to see live which
+// activity lets the ADC buffer overflow.
+void runningModes_reportBufferOverflows(bool printToConsole);
+
 // Group all of the inits together to reduce visual clutter.
 void runningModes_initAll(void);
 
@@ -82,6 +107,17 @@ void runningModes_continuous(void);
 // Transmit frequency is selected via the slide-switches.
 void runningModes_shooter(void);
 
+// Same as runningModes_shooter(), but in multi-hit mode: every frequency has
+// its own lockout, so concurrent shooters are all credited. Returns right away
+// with an error in AMP mode, where multi-hit mode is not supported.
+void runningModes_shooterMultiHit(void);
+
+// Run this mode at startup with no shooters present.
+// Collects several seconds of band-power statistics, then selects and keeps
+// the smallest safe hit-detection fudge factor. The noise floor of each band
+// is plotted on the TFT.
+void runningModes_calibrate(void);
+
 // This mode simply dumps raw ADC values to the console.
 // It can be used to determine if bipolar mode is working for the ADC.
 // Will loop forever. Stop the program with an external reset or Ctl-C.
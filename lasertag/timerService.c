@@ -0,0 +1,252 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "timerService.h"
+#include "utils.h"
+
+#ifdef ZYBO_BOARD
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#endif
+
+// Running timers, ordered so heap[0] has the earliest deadline.
+static timerService_timer_t *heap[TIMER_SERVICE_MAX_TIMERS];
+static uint16_t heapCount;
+// Milliseconds since timerService_init(). Wraps after 49 days, deadlines are
+// compared as differences so that is harmless.
+static volatile uint32_t now;
+
+///////////////////////
+/// HELPER FUNCTIONS //
+///////////////////////
+
+// Masks IRQs on this core and returns the previous CPSR. The heap is changed
+// both by the main loop and by timerService_tick() in the ISR. Saving and
+// restoring (instead of enabling) keeps this safe when called from the ISR.
+static inline uint32_t timerService_lock() {
+#ifdef ZYBO_BOARD
+    uint32_t cpsr = mfcpsr();
+    mtcpsr(cpsr | XREG_CPSR_IRQ_ENABLE);
+    return cpsr;
+#else
+    return 0;
+#endif
+}
+
+// Restores the CPSR saved by timerService_lock().
+static inline void timerService_unlock(uint32_t cpsr) {
+#ifdef ZYBO_BOARD
+    mtcpsr(cpsr);
+#else
+    (void)cpsr;
+#endif
+}
+
+// Returns true if deadline a comes before deadline b.
+static inline bool timerService_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+// Puts timer at position index of the heap.
+static inline void timerService_place(timerService_timer_t *timer, uint16_t index) {
+    heap[index] = timer;
+    timer->heapIndex = index;
+}
+
+// Moves the timer at index up until its parent is not later.
+static void timerService_siftUp(uint16_t index) {
+    timerService_timer_t *timer = heap[index];
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (!timerService_before(timer->deadline, heap[parent]->deadline)) break;
+        timerService_place(heap[parent], index);
+        index = parent;
+    }
+    timerService_place(timer, index);
+}
+
+// Moves the timer at index down until neither child is earlier.
+static void timerService_siftDown(uint16_t index) {
+    timerService_timer_t *timer = heap[index];
+    while (true) {
+        uint16_t child = 2 * index + 1;
+        if (child >= heapCount) break;
+        if (child + 1 < heapCount &&
+            timerService_before(heap[child + 1]->deadline, heap[child]->deadline))
+            child++;
+        if (!timerService_before(heap[child]->deadline, timer->deadline)) break;
+        timerService_place(heap[child], index);
+        index = child;
+    }
+    timerService_place(timer, index);
+}
+
+// Returns true if timer is in the heap. Also rejects a heapIndex that was
+// never set (e.g. a zeroed static timer that was not initialized).
+static inline bool timerService_inHeap(timerService_timer_t *timer) {
+    return timer->heapIndex >= 0 && timer->heapIndex < heapCount &&
+           heap[timer->heapIndex] == timer;
+}
+
+// Removes timer from the heap. Call with IRQs masked.
+static void timerService_remove(timerService_timer_t *timer) {
+    uint16_t index = timer->heapIndex;
+    timer->heapIndex = TIMER_SERVICE_IDLE;
+    heapCount--;
+    // Fill the hole with the last timer and restore the order
+    if (index != heapCount) {
+        timerService_timer_t *moved = heap[heapCount];
+        timerService_place(moved, index);
+        timerService_siftDown(index);
+        timerService_siftUp(moved->heapIndex);
+    }
+}
+
+/////////////////////
+/// MAIN FUNCTIONS //
+/////////////////////
+
+// Stops all timers and resets the clock.
+void timerService_init() {
+    uint32_t cpsr = timerService_lock();
+    for (uint16_t i = 0; i < heapCount; i++) heap[i]->heapIndex = TIMER_SERVICE_IDLE;
+    heapCount = 0;
+    now = 0;
+    timerService_unlock(cpsr);
+}
+
+// Sets up timer as not running, with callback called on expiry.
+void timerService_initTimer(timerService_timer_t *timer, timerService_callback_t callback) {
+    uint32_t cpsr = timerService_lock();
+    if (timerService_inHeap(timer)) timerService_remove(timer);
+    timer->heapIndex = TIMER_SERVICE_IDLE;
+    timer->deadline = 0;
+    timer->callback = callback;
+    timerService_unlock(cpsr);
+}
+
+// Starts (or restarts) timer so it expires durationMs milliseconds from now.
+bool timerService_start(timerService_timer_t *timer, uint32_t durationMs) {
+    uint32_t cpsr = timerService_lock();
+    if (timerService_inHeap(timer)) timerService_remove(timer);
+    if (heapCount == TIMER_SERVICE_MAX_TIMERS) {
+        timerService_unlock(cpsr);
+        printf("ERROR in timerService_start(): %d timers already running.\n",
+               TIMER_SERVICE_MAX_TIMERS);
+        return false;
+    }
+    timer->deadline = now + durationMs;
+    timerService_place(timer, heapCount++);
+    timerService_siftUp(timer->heapIndex);
+    timerService_unlock(cpsr);
+    return true;
+}
+
+// Stops timer without calling its callback.
+void timerService_cancel(timerService_timer_t *timer) {
+    uint32_t cpsr = timerService_lock();
+    if (timerService_inHeap(timer)) timerService_remove(timer);
+    timerService_unlock(cpsr);
+}
+
+// Returns true if timer has been started and has not expired or been canceled.
+// A zeroed timer that was never initialized also reads as not running.
+bool timerService_running(timerService_timer_t *timer) {
+    uint32_t cpsr = timerService_lock();
+    bool running = timerService_inHeap(timer);
+    timerService_unlock(cpsr);
+    return running;
+}
+
+// Returns the milliseconds until timer expires, 0 if it is not running.
+uint32_t timerService_remainingMs(timerService_timer_t *timer) {
+    uint32_t cpsr = timerService_lock();
+    uint32_t remaining = timerService_inHeap(timer) ? timer->deadline - now : 0;
+    timerService_unlock(cpsr);
+    return remaining;
+}
+
+// Returns the milliseconds since timerService_init().
+uint32_t timerService_now() {
+    return now;
+}
+
+// Advances the clock by 1 ms and expires the due timers.
+void timerService_tick() {
+    now++;
+    // Usually nothing is due and this is a single compare
+    while (heapCount && !timerService_before(now, heap[0]->deadline)) {
+        timerService_timer_t *timer = heap[0];
+        timerService_remove(timer);
+        if (timer->callback) timer->callback();
+    }
+}
+
+/******************************************************
+******************** Test Routines ********************
+******************************************************/
+
+#define TIMER_SERVICE_TEST_TIMER_COUNT 4
+#define TIMER_SERVICE_TEST_SHORT_MS 100
+#define TIMER_SERVICE_TEST_LONG_MS 300
+#define TIMER_SERVICE_TEST_WAIT_MS 500
+#define TIMER_SERVICE_TEST_TOLERANCE_MS 2
+
+static timerService_timer_t testTimers[TIMER_SERVICE_TEST_TIMER_COUNT];
+static volatile uint32_t testExpiredAt[TIMER_SERVICE_TEST_TIMER_COUNT];
+static timerService_timer_t testZeroedTimer; // Never initialized
+
+// Expiry callbacks record the time they were called.
+static void timerService_testExpired0() { testExpiredAt[0] = timerService_now(); }
+static void timerService_testExpired1() { testExpiredAt[1] = timerService_now(); }
+static void timerService_testExpired2() { testExpiredAt[2] = timerService_now(); }
+static void timerService_testExpired3() { testExpiredAt[3] = timerService_now(); }
+
+// Starts a few timers with different durations, including a restart and a
+// cancel, and checks that they expire in order and on time.
+void timerService_runTest() {
+    printf("STARTING: timerService_runTest()\n");
+    timerService_callback_t callbacks[TIMER_SERVICE_TEST_TIMER_COUNT] = {
+        timerService_testExpired0, timerService_testExpired1, timerService_testExpired2,
+        timerService_testExpired3};
+    uint32_t expectedMs[TIMER_SERVICE_TEST_TIMER_COUNT] = {
+        TIMER_SERVICE_TEST_LONG_MS, TIMER_SERVICE_TEST_SHORT_MS, TIMER_SERVICE_TEST_LONG_MS, 0};
+    for (uint16_t i = 0; i < TIMER_SERVICE_TEST_TIMER_COUNT; i++) {
+        timerService_initTimer(&testTimers[i], callbacks[i]);
+        testExpiredAt[i] = 0;
+    }
+    uint32_t start = timerService_now();
+    // Started in reverse order of expiry; timer 2 is restarted and timer 3 is
+    // canceled, so it must never expire (expected 0).
+    timerService_start(&testTimers[0], TIMER_SERVICE_TEST_LONG_MS);
+    timerService_start(&testTimers[2], TIMER_SERVICE_TEST_SHORT_MS);
+    timerService_start(&testTimers[1], TIMER_SERVICE_TEST_SHORT_MS);
+    timerService_start(&testTimers[3], TIMER_SERVICE_TEST_SHORT_MS);
+    timerService_start(&testTimers[2], TIMER_SERVICE_TEST_LONG_MS);
+    timerService_cancel(&testTimers[3]);
+    // heapIndex 0 of a zeroed timer must not match the timer in heap slot 0
+    bool passed = !timerService_running(&testZeroedTimer) &&
+                  timerService_remainingMs(&testZeroedTimer) == 0;
+    printf("zeroed timer running: %s (expected no)\n", passed ? "no" : "yes");
+    utils_msDelay(TIMER_SERVICE_TEST_WAIT_MS);
+
+    for (uint16_t i = 0; i < TIMER_SERVICE_TEST_TIMER_COUNT; i++) {
+        uint32_t elapsed = testExpiredAt[i] ? testExpiredAt[i] - start : 0;
+        int32_t error = (int32_t)elapsed - (int32_t)expectedMs[i];
+        if (error > TIMER_SERVICE_TEST_TOLERANCE_MS || error < -TIMER_SERVICE_TEST_TOLERANCE_MS ||
+            timerService_running(&testTimers[i]))
+            passed = false;
+        printf("timer %d: expired after %d ms (expected %d ms)\n", i, elapsed, expectedMs[i]);
+    }
+    printf("%s\n", passed ? "timerService test passed." : "timerService test FAILED.");
+    printf("TERMINATING: timerService_runTest()\n");
+}
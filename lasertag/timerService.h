@@ -0,0 +1,77 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef TIMERSERVICE_H_
+#define TIMERSERVICE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "isr.h"
+
+// One-shot software timers with millisecond resolution for game and gun
+// timing (hit LED, lockouts, invincibility, ...). Running timers are kept in a
+// min-heap ordered by absolute deadline, so timerService_tick() only compares
+// the clock with the earliest deadline; idle timers cost nothing per tick.
+// Start, cancel and query may be called from the main loop or from the ISR
+// (core 0 only). Expiry callbacks run in the ISR.
+
+// Timer interrupts between timerService_tick() calls (1 ms), see isr_init().
+#define TIMER_SERVICE_TICK_PERIOD ISR_TICKS_PER_MILLISECOND
+
+// Maximum number of timers that can run at the same time.
+#define TIMER_SERVICE_MAX_TIMERS 16
+
+// heapIndex of a timer that is not running.
+#define TIMER_SERVICE_IDLE -1
+
+// Called from the ISR when a timer expires.
+typedef void (*timerService_callback_t)();
+
+// A timer. Owned by the caller (usually a static in a module), set up with
+// timerService_initTimer(). Do not touch the fields directly.
+typedef struct {
+    uint32_t deadline; // timerService_now() value at which the timer expires
+    int16_t heapIndex; // Position in the deadline heap, or TIMER_SERVICE_IDLE
+    timerService_callback_t callback; // May be NULL
+} timerService_timer_t;
+
+// Stops all timers and resets the clock. Call before any other function.
+void timerService_init();
+
+// Sets up timer as not running. callback is called when it expires (NULL for
+// none). Stops the timer first if it is running.
+void timerService_initTimer(timerService_timer_t *timer, timerService_callback_t callback);
+
+// Starts timer so it expires durationMs milliseconds from now. Restarts it if
+// it is already running. Returns false (and prints an error) if
+// TIMER_SERVICE_MAX_TIMERS timers are already running.
+bool timerService_start(timerService_timer_t *timer, uint32_t durationMs);
+
+// Stops timer without calling its callback. Does nothing if it is not running.
+void timerService_cancel(timerService_timer_t *timer);
+
+// Returns true if timer has been started and has not expired or been canceled.
+bool timerService_running(timerService_timer_t *timer);
+
+// Returns the milliseconds until timer expires, 0 if it is not running.
+uint32_t timerService_remainingMs(timerService_timer_t *timer);
+
+// Returns the milliseconds since timerService_init().
+uint32_t timerService_now();
+
+// Advances the clock by 1 ms and expires the due timers. Registered with the
+// ISR scheduler (see isr_init()).
+void timerService_tick();
+
+// Starts a few timers with different durations, including a restart and a
+// cancel, and checks that they expire in order and on time. Needs the ISR
+// running.
+void timerService_runTest();
+
+#endif /* TIMERSERVICE_H_ */
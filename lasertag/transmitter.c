@@ -17,18 +17,47 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "buttons.h"
 #include "switches.h"
 #include "utils.h"
+#include "timerService.h"
+
+#ifdef ZYBO_BOARD
+#include "xgpiops_hw.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#endif
+
+#if TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_PWM
+#ifndef ZYBO_BOARD
+#error "TRANSMITTER_BACKEND_PWM needs the ZYBO board, use TRANSMITTER_BACKEND_STUB"
+#endif
+#include "xtmrctr.h"
+#endif
 
 #define DEBUG_TRANSMITTER false         // If true, debug messages enabled (slower)
-#define DEBUG_TRANSMITTER_TICKS false   // If true, tick count messages enabled (very slow) 
 
 // The transmitter state machine generates a square wave output at the chosen
 // frequency as set by transmitter_setFrequencyNumber(). The step counts for the
 // frequencies are provided in filter.h
+// Each tick only counts down to the next edge and to the end of the burst; the
+// length of every high or low segment is precomputed when the burst starts.
 #define TRANSMITTER_OUTPUT_PIN 13     // JF1 (pg. 25 of ZYBO reference manual).
 #define TRANSMITTER_PULSE_WIDTH 20000 // Based on a system tick-rate of 100 kHz.
 #define TRANSMITTER_HIGH_VALUE 1
 #define TRANSMITTER_LOW_VALUE 0
 
+// Burst length and tick length for the timer backends. The carrier keeps the
+// periods of filter_frequencyTickTable, which the receive filters are tuned to,
+// but without the tick quantization of each edge.
+#define TRANSMITTER_BURST_MS 200
+#define TRANSMITTER_NS_PER_TICK (1000000 / FILTER_SAMPLE_FREQUENCY_IN_KHZ)
+
+// The output pin is in MIO bank 0. Its mask/data register (MASK_DATA_0_LSW)
+// writes one pin in a single store: the upper half masks out the other 15
+// pins, the lower half holds the value.
+#define TRANSMITTER_PIN_REGISTER (XPAR_PS7_GPIO_0_BASEADDR + XGPIOPS_DATA_LSW_OFFSET)
+#define TRANSMITTER_PIN_MASK_BITS ((~(1u << TRANSMITTER_OUTPUT_PIN) & 0xFFFF) << 16)
+
 // All printed messages for states are provided here.
 #define INIT_ST_MSG "init state\n"
 #define INACTIVE_ST_MSG "default state\n"
@@ -47,11 +76,33 @@ volatile static uint16_t frequencyTicks;    // Number of ticks representing play
 volatile static uint16_t newFrequencyTicks; // Updated number of ticks for next cycle
 volatile static bool triggerPulled;     // Gun trigger pulled
 volatile static bool continuousMode;    // State machine should transmit continuously
+volatile static bool overridePending;   // The next burst uses overrideFrequency
+volatile static uint16_t overrideFrequency; // Set by transmitter_runAtFrequency()
+volatile static uint16_t overrideFrequencyTicks;
 static bool on;     // Whether the state machine is active or not
 
+// Waveform for the next burst, NULL for the square wave.
+static const transmitter_waveform_t *volatile newWaveform;
+
+// Edge schedule of the current burst. In square wave mode nextSegment points at
+// frequencyTicks and segmentStride is 0, so every segment has the same length;
+// in waveform mode it walks the segment table.
+static uint32_t burstTicksLeft;   // Ticks until the burst ends
+static uint16_t edgeCountdown;    // Ticks until the next edge
+static const uint16_t *nextSegment; // Length of the segment after the next edge
+static uint16_t segmentStride;
 
+// Timer backends: ends each burst, TRANSMITTER_BURST_MS after it started.
+static timerService_timer_t burstTimer;
+
+#if TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_PWM
+static XTmrCtr pwmTimer;
+#endif
+
+// Carrier starts and stops recorded by TRANSMITTER_BACKEND_STUB.
+static transmitter_carrierEdge_t carrierEdges[TRANSMITTER_CARRIER_EDGE_COUNT];
+static uint16_t carrierEdgeCount;
 
- 
 // State machine states
 enum transmitter_st_t {
     INIT_ST,
@@ -104,14 +155,148 @@ static void debugStatePrint() {
   }
 }
 
+// Writes value to the transmitter pin with one register store (no driver
+// call, no read-modify-write).
+static inline void transmitter_writePin(uint32_t value) {
+#ifdef ZYBO_BOARD
+  Xil_Out32(TRANSMITTER_PIN_REGISTER, TRANSMITTER_PIN_MASK_BITS | (value << TRANSMITTER_OUTPUT_PIN));
+#else
+  mio_writePin(TRANSMITTER_OUTPUT_PIN, value);
+#endif
+}
+
 // Set transmitter pin to 1
-static void transmitter_set_jf1_to_one() {
-  mio_writePin(TRANSMITTER_OUTPUT_PIN, TRANSMITTER_HIGH_VALUE); // Write a '1' to JF-1.
+static inline void transmitter_set_jf1_to_one() {
+  transmitter_writePin(TRANSMITTER_HIGH_VALUE); // Write a '1' to JF-1.
 }
 
 // Set transmitter pin to 0
-static void transmitter_set_jf1_to_zero() {
-  mio_writePin(TRANSMITTER_OUTPUT_PIN, TRANSMITTER_LOW_VALUE); // Write a '0' to JF-1.
+static inline void transmitter_set_jf1_to_zero() {
+  transmitter_writePin(TRANSMITTER_LOW_VALUE); // Write a '0' to JF-1.
+}
+
+// Takes the frequency of the burst that starts now: the one-shot frequency of
+// transmitter_runAtFrequency() if pending, the frequency setting otherwise.
+static void transmitter_latchFrequency() {
+    if (overridePending) {
+        frequency = overrideFrequency;
+        frequencyTicks = overrideFrequencyTicks;
+        overridePending = false;
+    } else {
+        frequency = newFrequency;
+        frequencyTicks = newFrequencyTicks;
+    }
+}
+
+// Precomputes the edge schedule of a burst and starts with the pin high.
+static void transmitter_startBurst() {
+    transmitter_latchFrequency();
+    const transmitter_waveform_t *waveform = newWaveform;
+    if (waveform) {
+        // Table-driven: the burst is exactly as long as its segments
+        burstTicksLeft = 0;
+        for (uint16_t i = 0; i < waveform->segmentCount; i++)
+            burstTicksLeft += waveform->segmentTicks[i];
+        edgeCountdown = waveform->segmentTicks[0];
+        nextSegment = &waveform->segmentTicks[1];
+        segmentStride = 1;
+    } else {
+        // Square wave: every segment is half a period
+        burstTicksLeft = TRANSMITTER_PULSE_WIDTH;
+        edgeCountdown = frequencyTicks;
+        nextSegment = (const uint16_t *)&frequencyTicks;
+        segmentStride = 0;
+    }
+    transmitter_set_jf1_to_one();
+}
+
+// Masks IRQs on this core and returns the previous CPSR. With the timer
+// backends a burst is started both from transmitter_run() and from the burst
+// timer callback in the ISR.
+static inline uint32_t transmitter_lock() {
+#ifdef ZYBO_BOARD
+  uint32_t cpsr = mfcpsr();
+  mtcpsr(cpsr | XREG_CPSR_IRQ_ENABLE);
+  return cpsr;
+#else
+  return 0;
+#endif
+}
+
+// Restores the CPSR saved by transmitter_lock().
+static inline void transmitter_unlock(uint32_t cpsr) {
+#ifdef ZYBO_BOARD
+  mtcpsr(cpsr);
+#else
+  (void)cpsr;
+#endif
+}
+
+// Records a carrier edge (stub backend).
+static void transmitter_recordCarrierEdge(uint32_t periodNs, uint32_t highNs) {
+  if (carrierEdgeCount == TRANSMITTER_CARRIER_EDGE_COUNT) return;
+  carrierEdges[carrierEdgeCount].timeMs = timerService_now();
+  carrierEdges[carrierEdgeCount].periodNs = periodNs;
+  carrierEdges[carrierEdgeCount].highNs = highNs;
+  carrierEdgeCount++;
+}
+
+// Prepares the carrier hardware (timer backends).
+static void transmitter_carrierInit() {
+#if TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_PWM
+  // PWM mode uses both counters: counter 0 sets the period, counter 1 the high
+  // time. XST_DEVICE_IS_STARTED only means it was initialized before.
+  int status = XTmrCtr_Initialize(&pwmTimer, TRANSMITTER_PWM_TIMER_DEVICE_ID);
+  if (status != XST_SUCCESS && status != XST_DEVICE_IS_STARTED)
+    printf("ERROR in transmitter_init(): PWM timer init failed (%d).\n", status);
+  XTmrCtr_PwmDisable(&pwmTimer);
+  XTmrCtr_SetOptions(&pwmTimer, XTC_TIMER_0, XTC_EXT_COMPARE_OPTION | XTC_DOWN_COUNT_OPTION);
+  XTmrCtr_SetOptions(&pwmTimer, XTC_TIMER_1, XTC_EXT_COMPARE_OPTION | XTC_DOWN_COUNT_OPTION);
+#endif
+  carrierEdgeCount = 0;
+}
+
+// Starts the carrier with the given period and high time (timer backends).
+static void transmitter_carrierStart(uint32_t periodNs, uint32_t highNs) {
+#if TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_PWM
+  XTmrCtr_PwmConfigure(&pwmTimer, periodNs, highNs);
+  XTmrCtr_PwmEnable(&pwmTimer);
+#else
+  transmitter_recordCarrierEdge(periodNs, highNs);
+#endif
+}
+
+// Stops the carrier, output low (timer backends).
+static void transmitter_carrierStop() {
+#if TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_PWM
+  XTmrCtr_PwmDisable(&pwmTimer);
+#else
+  transmitter_recordCarrierEdge(0, 0);
+#endif
+}
+
+// Starts a hardware carrier burst and the timer that ends it (timer backends).
+// Call with IRQs masked.
+static void transmitter_startCarrierBurst() {
+  transmitter_latchFrequency();
+  triggerPulled = false;
+  on = true;
+  currentState = ON_ST;
+  transmitter_carrierStart(2 * frequencyTicks * TRANSMITTER_NS_PER_TICK,
+                           frequencyTicks * TRANSMITTER_NS_PER_TICK);
+  timerService_start(&burstTimer, TRANSMITTER_BURST_MS);
+}
+
+// Burst timer callback (timer backends): stops the carrier, and starts the
+// next burst right away if one is pending.
+static void transmitter_burstExpired() {
+  transmitter_carrierStop();
+  if (triggerPulled || continuousMode) {
+    transmitter_startCarrierBurst();
+  } else {
+    currentState = INACTIVE_ST;
+    on = false;
+  }
 }
 
 ////////////////////////////
@@ -129,27 +314,36 @@ void transmitter_init() {
     newFrequency = 0;
     frequencyTicks = 0;
     newFrequencyTicks = 0;
+    burstTicksLeft = 0;
+    edgeCountdown = 0;
+    newWaveform = NULL;
 
     
     // Boolean default values
     triggerPulled = false;
     continuousMode = false;
+    overridePending = false;
     on = false;
 
     // Transition
     currentState = INIT_ST;
+    if (TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK) {
+        // No tick function to leave the init state
+        timerService_initTimer(&burstTimer, transmitter_burstExpired);
+        transmitter_carrierInit();
+        currentState = INACTIVE_ST;
+    }
     // printf("initialized\n");
 };
 
 
 
-// Standard tick function.
+// Standard tick function. Apart from starting a burst, a tick is two
+// decrements and compares; no division.
 void transmitter_tick() {
-    // Transmitter tick count
-    static uint32_t transmitterTick;
-    
+    // The timer backends are not ticked
+    if (TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK) return;
 
-    
     // Optional debug messages
     if (DEBUG_TRANSMITTER) debugStatePrint();
 
@@ -166,15 +360,9 @@ void transmitter_tick() {
                     // Reset variables for next 200ms pulse
                     on = true;
                     triggerPulled = false;
-                    transmitterTick = 1;
-                    // Update frequency and frequencyTicks values for next pulse
-                    frequency = newFrequency;
-                    frequencyTicks = newFrequencyTicks;
-                    // Optional debug: printf("frequency = %d\n", frequency);
-                    //Set JF1 pin to ON when transistion to ON_ST
-                    transmitter_set_jf1_to_one();
-                    
-                
+                    // Update frequency and the edge schedule for next pulse
+                    // and set JF1 pin to ON
+                    transmitter_startBurst();
             } else {
                 // Set on to false
                 on = false;
@@ -182,66 +370,31 @@ void transmitter_tick() {
             break;
 
         case ON_ST:
-            // Optional debug print
-            if (DEBUG_TRANSMITTER) printf("1");
-            // Check whether or not to terminate the pulse output
-            if (transmitterTick > TRANSMITTER_PULSE_WIDTH) {
-                currentState = INACTIVE_ST;
-                transmitterTick = 0;
-                transmitter_set_jf1_to_zero();
-            // Transition to off state depending on frequency
-            } else if((transmitterTick % frequencyTicks) == 0) {
-                currentState = OFF_ST;
-                // Optional debug print
-                if (DEBUG_TRANSMITTER) printf("\n");
-                //Set JF1 pin to OFF when transistion to OFF_ST
-                transmitter_set_jf1_to_zero();
-            }
-            break;
-
         case OFF_ST:
-
             // Optional debug print
-            if (DEBUG_TRANSMITTER) printf("0");
+            if (DEBUG_TRANSMITTER) printf(currentState == ON_ST ? "1" : "0");
             // Check whether or not to terminate the pulse output
-            if (transmitterTick > TRANSMITTER_PULSE_WIDTH) {
+            if (--burstTicksLeft == 0) {
                 currentState = INACTIVE_ST;
                 // Optional debug print
                 if (DEBUG_TRANSMITTER) printf("\n");
-                transmitterTick = 0;
-            // Transition to on state depending on frequency
-            } else if((transmitterTick % frequencyTicks) == 0) {
-                currentState = ON_ST;
-                //Set JF1 pin to ON when transistion to ON_ST
-                transmitter_set_jf1_to_one();
+                transmitter_set_jf1_to_zero();
+            // Toggle the output at the end of each segment
+            } else if (--edgeCountdown == 0) {
+                edgeCountdown = *nextSegment;
+                nextSegment += segmentStride;
+                if (currentState == ON_ST) {
+                    currentState = OFF_ST;
+                    //Set JF1 pin to OFF when transistion to OFF_ST
+                    transmitter_set_jf1_to_zero();
+                } else {
+                    currentState = ON_ST;
+                    //Set JF1 pin to ON when transistion to ON_ST
+                    transmitter_set_jf1_to_one();
+                }
             }
-    
-            break;
-        default:
-            // Error message here
-            printf(TRANSMITTER_UNKNOWN_ST_MSG);
             break;
-    }
 
-    // Perform state actions
-    switch(currentState) {
-        case INIT_ST:
-            break;
-        case INACTIVE_ST:
-            
-            break;
-        case ON_ST:
-            // Optional debug statement
-            if (DEBUG_TRANSMITTER_TICKS) printf("%d -> ",transmitterTick);
-            // Increment tick count
-            transmitterTick++;
-            // Optional debug statement
-            if (DEBUG_TRANSMITTER_TICKS) printf("%d\n",transmitterTick);
-            break;
-        case OFF_ST:
-            // Increment tick count
-            transmitterTick++;
-            break;
         default:
             // Error message here
             printf(TRANSMITTER_UNKNOWN_ST_MSG);
@@ -252,6 +405,24 @@ void transmitter_tick() {
 // Activate the transmitter.
 void transmitter_run() {
     triggerPulled = true;
+    // The timer backends start right away, or at the end of the current burst
+    if (TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK) {
+        uint32_t cpsr = transmitter_lock();
+        if (!on) transmitter_startCarrierBurst();
+        transmitter_unlock(cpsr);
+    }
+};
+
+// Activate the transmitter for one burst at frequencyNumber, without changing
+// the frequency setting used by the bursts after it.
+void transmitter_runAtFrequency(uint16_t frequencyNumber) {
+    // The tick backend latches the frequency from the ISR
+    uint32_t cpsr = transmitter_lock();
+    overrideFrequencyTicks = filter_getFrequencyTick(frequencyNumber) / DIVIDE_BY_TWO;
+    overrideFrequency = frequencyNumber;
+    overridePending = true;
+    transmitter_unlock(cpsr);
+    transmitter_run();
 };
 
 // Returns true if the transmitter is still running.
@@ -277,6 +448,27 @@ uint16_t transmitter_getFrequencyNumber() {
     return frequency;
 };
 
+// Sets the waveform of the following bursts, NULL for the square wave at the
+// frequency set with transmitter_setFrequencyNumber().
+bool transmitter_setWaveform(const transmitter_waveform_t *waveform) {
+    if (waveform && TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK) {
+        printf("ERROR in transmitter_setWaveform(): needs TRANSMITTER_BACKEND_TICK.\n");
+        return false;
+    }
+    if (waveform) {
+        // A zero-length segment would make the edge countdown wrap around
+        bool valid = waveform->segmentCount > 0;
+        for (uint16_t i = 0; valid && i < waveform->segmentCount; i++)
+            valid = waveform->segmentTicks[i] > 0;
+        if (!valid) {
+            printf("ERROR in transmitter_setWaveform(): empty segment.\n");
+            return false;
+        }
+    }
+    newWaveform = waveform;
+    return true;
+};
+
 // Runs the transmitter continuously.
 // if continuousModeFlag == true, transmitter runs continuously, otherwise, it
 // transmits one burst and stops. To set continuous mode, you must invoke
@@ -287,6 +479,19 @@ uint16_t transmitter_getFrequencyNumber() {
 // the transmitter will only change frequencies in between 200 ms bursts.
 void transmitter_setContinuousMode(bool continuousModeFlag) {
     continuousMode = continuousModeFlag;
+    // The tick backend starts from its inactive state, the timer backends here
+    if (continuousModeFlag && TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK) {
+        uint32_t cpsr = transmitter_lock();
+        if (!on) transmitter_startCarrierBurst();
+        transmitter_unlock(cpsr);
+    }
+};
+
+// Sets *edges to the carrier edges recorded by TRANSMITTER_BACKEND_STUB and
+// returns how many there are.
+uint16_t transmitter_getCarrierEdges(const transmitter_carrierEdge_t **edges) {
+    *edges = carrierEdges;
+    return carrierEdgeCount;
 };
 
 /******************************************************************************
@@ -373,4 +578,103 @@ void transmitter_runTestContinuous() {
     printf("exiting transmitter_runTestNoncontinuous()\n");
 };
 
+#define TRANSMITTER_TEST_SEGMENT_COUNT 6
+
+// Two short 30% duty pulses, then a long pulse (lengths in ticks).
+static const uint16_t testSegmentTicks[TRANSMITTER_TEST_SEGMENT_COUNT] = {30, 70, 30, 70, 500, 100};
+static const transmitter_waveform_t testWaveform = {testSegmentTicks, TRANSMITTER_TEST_SEGMENT_COUNT};
+
+// Runs a multi-segment waveform burst by calling the tick function in a loop
+// and checks the length of every segment.
+void transmitter_runTestWaveform() {
+    printf("starting transmitter_runTestWaveform()\n");
+    transmitter_init();
+    transmitter_setWaveform(&testWaveform);
+    transmitter_tick();     // Leave the init state.
+    transmitter_run();
+    transmitter_tick();     // Starts the burst, the output goes high.
+
+    // Measure the ticks between state changes until the burst ends.
+    uint32_t measuredTicks[TRANSMITTER_TEST_SEGMENT_COUNT + 1] = {0};
+    uint16_t segment = 0;
+    enum transmitter_st_t previousState = currentState;
+    while (currentState != INACTIVE_ST && segment < TRANSMITTER_TEST_SEGMENT_COUNT) {
+        transmitter_tick();
+        measuredTicks[segment]++;
+        if (currentState != previousState) {
+            previousState = currentState;
+            segment++;
+        }
+    }
+
+    bool passed = segment == TRANSMITTER_TEST_SEGMENT_COUNT;
+    for (uint16_t i = 0; i < TRANSMITTER_TEST_SEGMENT_COUNT; i++) {
+        printf("segment %d: %d ticks (expected %d)\n", i, measuredTicks[i], testSegmentTicks[i]);
+        if (measuredTicks[i] != testSegmentTicks[i]) passed = false;
+    }
+    transmitter_setWaveform(NULL);
+    printf("%s\n", passed ? "transmitter waveform test passed." : "transmitter waveform test FAILED.");
+    printf("exiting transmitter_runTestWaveform()\n");
+};
+
+#define TRANSMITTER_TEST_FREQUENCY_NUMBER 3
+#define TRANSMITTER_TEST_CARRIER_EDGE_COUNT 6 // Three bursts
+#define TRANSMITTER_TEST_MARGIN_MS 2
 
+// Advances the timer service by ms milliseconds.
+static void transmitter_testAdvanceMs(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) timerService_tick();
+}
+
+// Checks that edge index of the stub log is at timeMs and starts the test
+// frequency (start true) or stops the carrier.
+static bool transmitter_testCarrierEdge(uint16_t index, uint32_t timeMs, bool start) {
+    const transmitter_carrierEdge_t *edges;
+    if (index >= transmitter_getCarrierEdges(&edges)) return false;
+    uint32_t halfPeriodNs = filter_getFrequencyTick(TRANSMITTER_TEST_FREQUENCY_NUMBER) /
+                            DIVIDE_BY_TWO * TRANSMITTER_NS_PER_TICK;
+    printf("edge %d: %d ms, period %d ns, high %d ns\n", index, edges[index].timeMs,
+           edges[index].periodNs, edges[index].highNs);
+    return edges[index].timeMs == timeMs &&
+           edges[index].periodNs == (start ? 2 * halfPeriodNs : 0) &&
+           edges[index].highNs == (start ? halfPeriodNs : 0);
+}
+
+// Runs a single and two continuous bursts by calling timerService_tick() in a
+// loop and checks when the transmitter stops, and the recorded carrier edges.
+void transmitter_runTestCarrier() {
+    printf("starting transmitter_runTestCarrier()\n");
+    bool passed = TRANSMITTER_BACKEND != TRANSMITTER_BACKEND_TICK;
+    transmitter_init();
+    transmitter_setFrequencyNumber(TRANSMITTER_TEST_FREQUENCY_NUMBER);
+    uint32_t start = timerService_now();
+
+    // Single burst: running for exactly TRANSMITTER_BURST_MS
+    transmitter_run();
+    transmitter_testAdvanceMs(TRANSMITTER_BURST_MS - 1);
+    if (!transmitter_running()) passed = false;
+    transmitter_testAdvanceMs(1);
+    if (transmitter_running()) passed = false;
+
+    // Continuous: back-to-back bursts until continuous mode is turned off
+    transmitter_testAdvanceMs(TRANSMITTER_TEST_MARGIN_MS);
+    transmitter_setContinuousMode(true);
+    transmitter_testAdvanceMs(TRANSMITTER_BURST_MS + TRANSMITTER_TEST_MARGIN_MS);
+    transmitter_setContinuousMode(false);
+    transmitter_testAdvanceMs(TRANSMITTER_BURST_MS);
+    if (transmitter_running()) passed = false;
+
+    if (TRANSMITTER_BACKEND == TRANSMITTER_BACKEND_STUB) {
+        uint32_t second = start + TRANSMITTER_BURST_MS + TRANSMITTER_TEST_MARGIN_MS;
+        const transmitter_carrierEdge_t *edges;
+        passed = passed && transmitter_getCarrierEdges(&edges) == TRANSMITTER_TEST_CARRIER_EDGE_COUNT &&
+                 transmitter_testCarrierEdge(0, start, true) &&
+                 transmitter_testCarrierEdge(1, start + TRANSMITTER_BURST_MS, false) &&
+                 transmitter_testCarrierEdge(2, second, true) &&
+                 transmitter_testCarrierEdge(3, second + TRANSMITTER_BURST_MS, false) &&
+                 transmitter_testCarrierEdge(4, second + TRANSMITTER_BURST_MS, true) &&
+                 transmitter_testCarrierEdge(5, second + 2 * TRANSMITTER_BURST_MS, false);
+    }
+    printf("%s\n", passed ? "transmitter carrier test passed." : "transmitter carrier test FAILED.");
+    printf("exiting transmitter_runTestCarrier()\n");
+};
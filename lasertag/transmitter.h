@@ -17,15 +17,69 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // frequency as set by transmitter_setFrequencyNumber(). The step counts for the
 // frequencies are provided in filter.h
 
+// How the carrier is generated, selected with TRANSMITTER_BACKEND:
+// TRANSMITTER_BACKEND_TICK: transmitter_tick() toggles MIO pin 13 (JF1) from
+//   the timer interrupt. Quantized to 10 us ticks and subject to ISR jitter.
+// TRANSMITTER_BACKEND_PWM: an AXI timer (TRANSMITTER_PWM_TIMER_DEVICE_ID) in
+//   PWM mode generates the carrier in hardware. The ISR only starts and ends
+//   each 200 ms burst on the timer service; transmitter_tick() is not called.
+//   The PWM output is a PL pin, so the bitstream must route it to the IR LED.
+// TRANSMITTER_BACKEND_STUB: same burst control as PWM, but the carrier starts
+//   and stops are only recorded (see transmitter_getCarrierEdges()), for
+//   testing on a host or on a board without the PWM routing.
+#define TRANSMITTER_BACKEND_TICK 0
+#define TRANSMITTER_BACKEND_PWM 1
+#define TRANSMITTER_BACKEND_STUB 2
+
+#ifndef TRANSMITTER_BACKEND
+#define TRANSMITTER_BACKEND TRANSMITTER_BACKEND_TICK
+#endif
+
+// The AXI timer used by TRANSMITTER_BACKEND_PWM (both of its counters). All
+// three AXI timers are interval timers; with this backend runningModes.c and
+// game.c leave timer 2 (MAIN_CUMULATIVE_TIMER) alone and do not time the main
+// loop, see RUNNING_MODES_MAIN_LOOP_TIMED.
+#ifndef TRANSMITTER_PWM_TIMER_DEVICE_ID
+#define TRANSMITTER_PWM_TIMER_DEVICE_ID XPAR_TMRCTR_2_DEVICE_ID
+#endif
+
+// Number of carrier edges kept by TRANSMITTER_BACKEND_STUB.
+#define TRANSMITTER_CARRIER_EDGE_COUNT 16
+
+// A carrier start (periodNs > 0) or stop (periodNs == 0) recorded by
+// TRANSMITTER_BACKEND_STUB, at timerService_now() milliseconds.
+typedef struct {
+    uint32_t timeMs;
+    uint32_t periodNs;
+    uint32_t highNs;
+} transmitter_carrierEdge_t;
+
+// A shot described as a table of segment lengths in ticks (10 us each). The
+// output is high during even segments (starting with segment 0) and low during
+// odd ones, so any duty cycle or multi-pulse shot can be described. The burst
+// ends, with the output low, after the last segment. No segment may be 0.
+typedef struct {
+    const uint16_t *segmentTicks;
+    uint16_t segmentCount;
+} transmitter_waveform_t;
+
 // Standard init function.
 void transmitter_init();
 
-// Standard tick function.
+// Standard tick function. Does nothing unless TRANSMITTER_BACKEND is
+// TRANSMITTER_BACKEND_TICK.
 void transmitter_tick();
 
 // Activate the transmitter.
 void transmitter_run();
 
+// Activate the transmitter for one burst at frequencyNumber. The frequency set
+// with transmitter_setFrequencyNumber() is left alone and used again from the
+// following burst on, so setting it in the meantime (e.g. from the switches on
+// every main-loop pass) does not change this burst. If a burst is running, the
+// override applies to the next one.
+void transmitter_runAtFrequency(uint16_t frequencyNumber);
+
 // Returns true if the transmitter is still running.
 bool transmitter_running();
 
@@ -37,6 +91,13 @@ void transmitter_setFrequencyNumber(uint16_t frequencyNumber);
 // Returns the current frequency setting.
 uint16_t transmitter_getFrequencyNumber();
 
+// Uses waveform for the following bursts instead of the square wave, NULL
+// returns to the square wave. Like the frequency, a change takes effect at the
+// next burst. waveform and its table must stay valid while in use. Returns
+// false (and keeps the current setting) if it has no segments or a 0 segment.
+// Waveforms need TRANSMITTER_BACKEND_TICK; other backends return false.
+bool transmitter_setWaveform(const transmitter_waveform_t *waveform);
+
 // Runs the transmitter continuously.
 // if continuousModeFlag == true, transmitter runs continuously, otherwise, it
 // transmits one burst and stops. To set continuous mode, you must invoke
@@ -47,6 +108,11 @@ uint16_t transmitter_getFrequencyNumber();
 // the transmitter will only change frequencies in between 200 ms bursts.
 void transmitter_setContinuousMode(bool continuousModeFlag);
 
+// Sets *edges to the carrier edges recorded by TRANSMITTER_BACKEND_STUB since
+// transmitter_init() and returns how many there are (at most
+// TRANSMITTER_CARRIER_EDGE_COUNT). Always 0 with the other backends.
+uint16_t transmitter_getCarrierEdges(const transmitter_carrierEdge_t **edges);
+
 /******************************************************************************
 ***** Test Functions
 ******************************************************************************/
@@ -76,4 +142,14 @@ void transmitter_runTestNoncontinuous();
 // Depends on the interrupt handler to call tick function.
 void transmitter_runTestContinuous();
 
+// Runs a multi-segment waveform burst by calling the tick function in a loop
+// and checks the length of every segment. Run it with interrupts disabled.
+void transmitter_runTestWaveform();
+
+// Runs a single and two continuous bursts by calling timerService_tick() in a
+// loop and checks when the transmitter stops (and, with
+// TRANSMITTER_BACKEND_STUB, the recorded carrier edges). Needs a backend
+// other than TRANSMITTER_BACKEND_TICK. Run it with interrupts disabled.
+void transmitter_runTestCarrier();
+
 #endif /* TRANSMITTER_H_ */
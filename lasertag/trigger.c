@@ -58,6 +58,9 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define MAYBE_PRESSED_ST_MSG "maybe pressed state\n"
 #define WAIT_FOR_RELEASE_ST_MSG "wait for release state\n"
 #define MAYBE_RELEASED_ST_MSG "maybe released state\n"
+#define CHARGED_WAIT_FOR_IDLE_ST_MSG "charged wait for idle state\n"
+#define CHARGED_WAIT_FOR_START_ST_MSG "charged wait for start state\n"
+#define CHARGED_WAIT_FOR_END_ST_MSG "charged wait for end state\n"
 #define TRIGGER_UNKNOWN_ST_MSG "ERROR: Unknown state in Trigger\n"
 
 
@@ -68,6 +71,11 @@ enum trigger_st_st {
     MAYBE_PRESSED_ST,       // Waiting a certain time period to confirm button press
     WAIT_FOR_RELEASE_ST,    // Waiting to be released
     MAYBE_RELEASED_ST,      // Waiting a certain time period to confirm button release
+    // A charged shot is a sequence of states so trigger_tick() never waits
+    // on the transmitter, which is ticked by the same ISR
+    CHARGED_WAIT_FOR_IDLE_ST,   // Waiting for the transmitter to finish a burst
+    CHARGED_WAIT_FOR_START_ST,  // Charged burst requested, waiting for it to start
+    CHARGED_WAIT_FOR_END_ST,    // Waiting for the charged burst to end
 };
 static enum trigger_st_st currentState;
 
@@ -77,6 +85,7 @@ volatile static trigger_shotsRemaining_t shotsRemaining;    // Remaining shots
 volatile static uint32_t mainTickCount; // Main tick count (used for half second trigger delay until next shot)
 volatile static uint32_t reloadTickCount; // Reload tick count (used to measure three second reload delay)
 volatile static uint32_t chargedShotTickCount;  // Tick count waiting for charged shot
+volatile static uint32_t chargedWaitTickCount;  // Ticks spent in the current CHARGED_* state
 // Booleans
 volatile static bool enable;    // Enable trigger SM
 volatile static bool pressConfirmed;    // Confirm a press
@@ -117,6 +126,15 @@ static void debugStatePrint() {
         case MAYBE_RELEASED_ST:
             printf(MAYBE_RELEASED_ST_MSG);
             break;
+        case CHARGED_WAIT_FOR_IDLE_ST:
+            printf(CHARGED_WAIT_FOR_IDLE_ST_MSG);
+            break;
+        case CHARGED_WAIT_FOR_START_ST:
+            printf(CHARGED_WAIT_FOR_START_ST_MSG);
+            break;
+        case CHARGED_WAIT_FOR_END_ST:
+            printf(CHARGED_WAIT_FOR_END_ST_MSG);
+            break;
         default:
             // Error message here
             printf(TRIGGER_UNKNOWN_ST_MSG);
@@ -156,6 +174,7 @@ void trigger_init() {
     mainTickCount = 0;
     reloadTickCount = 0;
     chargedShotTickCount = 0;
+    chargedWaitTickCount = 0;
     enable = false;
     pressConfirmed = false;
     releaseConfirmed = false;
@@ -179,27 +198,27 @@ static void trigger_fire_default(void){
     if (DEBUG_RELOAD) printf("FIRE\n");
 }
 
-// Play charged firing sound
+// Play charged firing sound. The shot itself is sent by the CHARGED_* states.
 static void trigger_fire_charged(void){
     // Play sound and decrement shots
     shotsRemaining--;
     sound_playSound(sound_gunFire_e);
+}
 
-    // Temporarily change frequency to shoot and restore the old frequency
-    uint32_t currentFrequency = transmitter_getFrequencyNumber();
+// Send the charged shot, the transmitter must be idle. The charged frequency
+// only applies to this burst, the frequency setting is left alone.
+static void trigger_transmit_charged(void){
     // Set frequency depending on team
     if (isTeamA)
-        transmitter_setFrequencyNumber(TEAM_A_CHARGED_SHOOT_FREQUENCY);
-    else 
-        transmitter_setFrequencyNumber(TEAM_B_CHARGED_SHOOT_FREQUENCY);
-    utils_msDelay(1);
-    transmitter_run();
-    // Wait for the transmitter to stop running
-    while (transmitter_running());
-    // NOTE that for some reason setting the frequency back here makes it NOT work...
-    // So just don't set it back...
-    // Optional global debug
-    if (DEBUG_RELOAD) printf("BOOM\n");
+        transmitter_runAtFrequency(TEAM_A_CHARGED_SHOOT_FREQUENCY);
+    else
+        transmitter_runAtFrequency(TEAM_B_CHARGED_SHOOT_FREQUENCY);
+}
+
+// Give up a charged shot whose transmitter state never came
+static void trigger_charged_timeout(void){
+    currentState = WAIT_FOR_PRESS_ST;
+    printf("ERROR in trigger_tick(): charged shot timed out.\n");
 }
 
 // Reload gun with max bullets in clip
@@ -309,12 +328,14 @@ void trigger_tick(void) {
             // Else If mainTickCount is greater than 50 ms, transition to WAIT_FOR_PRESS_ST
             } else if (mainTickCount >= TRIGGER_DEBOUNCE_RELEASE_DELAY) {
                 
+                currentState = WAIT_FOR_PRESS_ST;
                 if(charged){
                     trigger_fire_charged(); //shoots gun
                     charged = false; //discharge gun
+                    currentState = CHARGED_WAIT_FOR_IDLE_ST;
+                    chargedWaitTickCount = 0;
                 }
 
-                currentState = WAIT_FOR_PRESS_ST;
                 mainTickCount = 0;
                 pressConfirmed = false;
                 releaseConfirmed = true;
@@ -323,6 +344,37 @@ void trigger_tick(void) {
             }
             break;
 
+        case CHARGED_WAIT_FOR_IDLE_ST:
+            // Send the charged shot once the current burst is over
+            if (!transmitter_running()) {
+                currentState = CHARGED_WAIT_FOR_START_ST;
+                chargedWaitTickCount = 0;
+                trigger_transmit_charged();
+            } else if (chargedWaitTickCount >= TRIGGER_CHARGED_WAIT_TIMEOUT_TICKS) {
+                trigger_charged_timeout();
+            }
+            break;
+
+        case CHARGED_WAIT_FOR_START_ST:
+            // The tick backend starts the burst on its next tick
+            if (transmitter_running()) {
+                currentState = CHARGED_WAIT_FOR_END_ST;
+                chargedWaitTickCount = 0;
+            } else if (chargedWaitTickCount >= TRIGGER_CHARGED_WAIT_TIMEOUT_TICKS) {
+                trigger_charged_timeout();
+            }
+            break;
+
+        case CHARGED_WAIT_FOR_END_ST:
+            if (!transmitter_running()) {
+                currentState = WAIT_FOR_PRESS_ST;
+                // Optional global debug
+                if (DEBUG_RELOAD) printf("BOOM\n");
+            } else if (chargedWaitTickCount >= TRIGGER_CHARGED_WAIT_TIMEOUT_TICKS) {
+                trigger_charged_timeout();
+            }
+            break;
+
         default:
             // Error message here
             printf(TRIGGER_UNKNOWN_ST_MSG);
@@ -352,6 +404,12 @@ void trigger_tick(void) {
             // Increment tick counter
             if (!invincibilityTimer_running()) mainTickCount++;
             break;
+        case CHARGED_WAIT_FOR_IDLE_ST:
+        case CHARGED_WAIT_FOR_START_ST:
+        case CHARGED_WAIT_FOR_END_ST:
+            // Count toward TRIGGER_CHARGED_WAIT_TIMEOUT_TICKS
+            chargedWaitTickCount++;
+            break;
         default:
             // Error message here
             printf(TRIGGER_UNKNOWN_ST_MSG);
@@ -12,14 +12,22 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 
 #define TRIGGER_GUN_TRIGGER_MIO_PIN 10     // JF2 (pg. 25 of ZYBO reference manual).
 
+// Timer interrupts between trigger_tick() calls (1 ms), see isr_init().
+#define TRIGGER_TICK_PERIOD ISR_TICKS_PER_MILLISECOND
+
 // Debouncing values
-#define TRIGGER_DEBOUNCE_PRESS_DELAY 50 // ticks, 50 ms
-#define TRIGGER_DEBOUNCE_RELEASE_DELAY 50 // ticks, 50 ms
+#define TRIGGER_DEBOUNCE_PRESS_DELAY 50 // trigger_tick() calls, 50 ms
+#define TRIGGER_DEBOUNCE_RELEASE_DELAY 50 // trigger_tick() calls, 50 ms
 #define TRIGGER_DEBOUNCE_MILLISECOND_DELAY 1    // Slow down the loop
 
 #define SHOT_COUNT_MAX 10
-#define TRIGGER_RELOAD_AUTOMATIC_DELAY_TICKS 300000
-#define TRIGGER_CHARGED_SHOT_DELAY_TICKS 300000
+// In trigger_tick() calls (3 s).
+#define TRIGGER_RELOAD_AUTOMATIC_DELAY_TICKS (300000 / TRIGGER_TICK_PERIOD)
+#define TRIGGER_CHARGED_SHOT_DELAY_TICKS (300000 / TRIGGER_TICK_PERIOD)
+// Longest wait in each charged-shot state, in trigger_tick() calls (1 s). A
+// burst takes 200 ms, so this only trips if the transmitter is stuck or in
+// continuous mode; the charged shot is then given up.
+#define TRIGGER_CHARGED_WAIT_TIMEOUT_TICKS (100000 / TRIGGER_TICK_PERIOD)
 
 #define TEAM_A_DEFAULT_SHOOT_FREQUENCY 6
 #define TEAM_A_CHARGED_SHOOT_FREQUENCY 7
@@ -28,6 +36,7 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define TEAM_B_CHARGED_SHOOT_FREQUENCY 8
  
 #include <stdint.h>
+#include "isr.h"
 
 // The trigger state machine debounces both the press and release of gun
 // trigger. Ultimately, it will activate the transmitter when a debounced press